@@ -0,0 +1,518 @@
+#include "headers/AiSearch.h"
+#include "headers/TetrisGame.h"
+#include "headers/Trace.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+// Pierre Dellacherie's features with the El-Tetris weights
+const float WEIGHT_LANDING_HEIGHT = -4.500158825082766f;
+const float WEIGHT_ERODED_CELLS = 3.4181268101392694f;
+const float WEIGHT_ROW_TRANSITIONS = -3.2178882868487753f;
+const float WEIGHT_COLUMN_TRANSITIONS = -9.348695305445199f;
+const float WEIGHT_HOLES = -7.899265427351652f;
+const float WEIGHT_WELLS = -3.3855972247263626f;
+
+// One orientation of a piece in its 4x4 box
+struct AiRotation {
+    uint32_t rows[4]; // Bit j = box column j
+    int minRow, maxRow, minCol, maxCol;
+    int bottom[4];    // Lowest filled row per box column, -1 if empty
+    bool distinct;    // False if an earlier rotation has the same shape (O, and half of I, S, Z)
+};
+
+struct AiPiece {
+    AiRotation rotations[4]; // After 0-3 clockwise TetrisPiece::rotate() calls
+};
+
+const AiPiece* pieces() {
+    static const std::vector<AiPiece> table = [] {
+        std::vector<AiPiece> built(AI_PIECE_TYPES);
+        for (int type = 0; type < AI_PIECE_TYPES; type++) {
+            TetrisPiece piece(type);
+            for (int r = 0; r < 4; r++) {
+                AiRotation& rotation = built[type].rotations[r];
+                rotation.minRow = rotation.minCol = 4;
+                rotation.maxRow = rotation.maxCol = -1;
+                for (int i = 0; i < 4; i++) {
+                    rotation.rows[i] = 0;
+                    for (int j = 0; j < 4; j++) {
+                        if (piece.shape[i][j] == 0) continue;
+                        rotation.rows[i] |= 1u << j;
+                        rotation.minRow = std::min(rotation.minRow, i);
+                        rotation.maxRow = std::max(rotation.maxRow, i);
+                        rotation.minCol = std::min(rotation.minCol, j);
+                        rotation.maxCol = std::max(rotation.maxCol, j);
+                    }
+                }
+                for (int j = 0; j < 4; j++) rotation.bottom[j] = piece.bottom[j];
+                
+                // Same cells up to a shift of the box: the same set of placements
+                rotation.distinct = true;
+                for (int earlier = 0; earlier < r; earlier++) {
+                    const AiRotation& other = built[type].rotations[earlier];
+                    bool same = other.maxRow - other.minRow == rotation.maxRow - rotation.minRow;
+                    for (int i = 0; same && i <= rotation.maxRow - rotation.minRow; i++) {
+                        same = other.rows[other.minRow + i] >> other.minCol ==
+                               rotation.rows[rotation.minRow + i] >> rotation.minCol;
+                    }
+                    if (same) rotation.distinct = false;
+                }
+                piece.rotate();
+            }
+        }
+        return built;
+    }();
+    return table.data();
+}
+
+inline uint32_t shiftRow(uint32_t mask, int x) {
+    return x >= 0 ? mask << x : mask >> -x;
+}
+
+inline uint32_t fullRow(int width) {
+    return width >= 32 ? ~0u : (1u << width) - 1;
+}
+
+inline uint64_t mix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+// Zobrist-style key of one row at height y. A board's hash is the XOR over its non-empty
+// rows, so a placement only rehashes the rows it changed (see lockPiece()).
+inline uint64_t rowHash(int y, uint32_t mask) {
+    return mask ? mix64((uint64_t)y << 32 | mask) : 0;
+}
+
+inline int popcount(uint64_t value) {
+    return __builtin_popcountll(value);
+}
+
+bool fits(const AiBoard& board, const AiRotation& rotation, int x, int y) {
+    if (x + rotation.minCol < 0 || x + rotation.maxCol >= board.width) return false;
+    for (int i = rotation.minRow; i <= rotation.maxRow; i++) {
+        int row = y + i;
+        if (row >= board.height) return false;
+        if (row >= 0 && (board.rows[row] & shiftRow(rotation.rows[i], x))) return false;
+    }
+    return true;
+}
+
+// First filled row of each column, height if the column is empty
+void columnTops(const AiBoard& board, int* tops) {
+    uint32_t full = fullRow(board.width);
+    uint32_t seen = 0;
+    for (int x = 0; x < board.width; x++) tops[x] = board.height;
+    for (int y = board.stackTop(); y < board.height && seen != full; y++) {
+        uint32_t fresh = board.rows[y] & ~seen;
+        while (fresh) {
+            tops[__builtin_ctz(fresh)] = y;
+            fresh &= fresh - 1;
+        }
+        seen |= board.rows[y];
+    }
+}
+
+// Row a hard drop from the top of the board ends on
+int landingRow(const AiBoard& board, const AiRotation& rotation, int x, const int* tops) {
+    int y = board.height;
+    for (int j = rotation.minCol; j <= rotation.maxCol; j++) {
+        int top = tops[x + j];
+        if (rotation.bottom[j] >= top) {
+            // Under an overhang, the column tops don't describe the cells below the piece
+            y = 0;
+            while (fits(board, rotation, x, y + 1)) y++;
+            return y;
+        }
+        y = std::min(y, top - 1 - rotation.bottom[j]);
+    }
+    return y;
+}
+
+// Score of the placement itself: landing height and eroded cells
+inline float placementScore(const AiBoard& board, const AiRotation& rotation, int y, int cleared, int erodedCells) {
+    float landingHeight = board.height - y - (rotation.minRow + rotation.maxRow) * 0.5f;
+    return WEIGHT_LANDING_HEIGHT * landingHeight + WEIGHT_ERODED_CELLS * (float)(cleared * erodedCells);
+}
+
+// Locks the piece into a copy of the board and clears lines, returns the placement's own score.
+// If `hash` holds the board's hash it is updated to out's.
+float lockPiece(const AiBoard& board, const AiRotation& rotation, int x, int y, AiBoard& out,
+                uint64_t* hash = nullptr) {
+    out.width = board.width;
+    out.height = board.height;
+    std::memcpy(out.rows, board.rows, sizeof(uint32_t) * board.height);
+    uint32_t full = fullRow(board.width);
+    int cleared = 0, erodedCells = 0;
+    for (int i = rotation.minRow; i <= rotation.maxRow; i++) {
+        uint32_t& row = out.rows[y + i];
+        row |= shiftRow(rotation.rows[i], x);
+        if (row == full) {
+            cleared++;
+            erodedCells += popcount(rotation.rows[i]);
+        }
+    }
+    if (cleared > 0) {
+        int write = y + rotation.maxRow;
+        for (int read = write; read >= 0; read--) {
+            if (out.rows[read] != full) out.rows[write--] = out.rows[read];
+        }
+        for (; write >= 0; write--) out.rows[write] = 0;
+    }
+    if (hash) {
+        // The piece's rows, and after a clear every row down to it, since the stack above shifted
+        int first = cleared > 0 ? std::min(board.stackTop(), y + rotation.minRow) : y + rotation.minRow;
+        for (int row = first; row <= y + rotation.maxRow; row++) {
+            *hash ^= rowHash(row, board.rows[row]) ^ rowHash(row, out.rows[row]);
+        }
+    }
+    return placementScore(board, rotation, y, cleared, erodedCells);
+}
+
+// A placement with the board it leaves behind
+struct AiChild {
+    int rotations, x;
+    float score;   // Of the placement itself: landing height and eroded cells
+    uint64_t hash; // Of board, only filled in when a table is used
+    AiBoard board;
+};
+
+const int AI_MAX_CHILDREN = 4 * AI_MAX_WIDTH;
+
+// Calls visit(rotations, rotation, x, landing row) for every placement the game's moves
+// can reach: rotate at spawn, shift sideways on the spawn row, hard drop
+template <typename Visit>
+void forEachPlacement(const AiBoard& board, int type, Visit visit) {
+    const AiPiece& piece = pieces()[type];
+    int spawnX = board.width / 2 - 2;
+    int tops[AI_MAX_WIDTH];
+    columnTops(board, tops);
+    for (int r = 0; r < 4; r++) {
+        const AiRotation& rotation = piece.rotations[r];
+        if (!fits(board, rotation, spawnX, 0)) break; // The game refuses this rotation and every later one
+        if (!rotation.distinct) continue;
+        int left = spawnX, right = spawnX;
+        while (fits(board, rotation, left - 1, 0)) left--;
+        while (fits(board, rotation, right + 1, 0)) right++;
+        for (int x = left; x <= right; x++) visit(r, rotation, x, landingRow(board, rotation, x, tops));
+    }
+}
+
+// Every placement locked into `children`, returns how many there are. Given the board's
+// hash, the children's hashes are derived from it.
+int expand(const AiBoard& board, int type, AiChild* children, const uint64_t* boardHash = nullptr) {
+    int count = 0;
+    forEachPlacement(board, type, [&](int rotations, const AiRotation& rotation, int x, int y) {
+        AiChild& child = children[count++];
+        child.rotations = rotations;
+        child.x = x;
+        child.hash = boardHash ? *boardHash : 0;
+        child.score = lockPiece(board, rotation, x, y, child.board, boardHash ? &child.hash : nullptr);
+    });
+    return count;
+}
+
+// Everything one search thread passes down the tree
+struct SearchContext {
+    TranspositionTable* table = nullptr; // Optional
+    unsigned placedTypes = 0;            // Bit per piece type placed on the way to the current node
+    bool repeatedType = false;           // Whether one of those types was placed twice
+    AiSearchStats stats;
+};
+
+// Pieces known beyond a node's own piece, packed as a 4-bit count followed by 3 bits per
+// type, so the sequence can be part of the table key
+inline uint64_t packPreview(const int* types, int count) {
+    uint64_t packed = (uint64_t)count;
+    for (int i = 0; i < count; i++) packed |= (uint64_t)types[i] << (4 + 3 * i);
+    return packed;
+}
+
+inline int previewCount(uint64_t preview) {
+    return (int)(preview & 15);
+}
+
+inline int previewFront(uint64_t preview) {
+    return (int)((preview >> 4) & 7);
+}
+
+inline uint64_t previewRest(uint64_t preview) {
+    return (preview >> 7) << 4 | (uint64_t)(previewCount(preview) - 1);
+}
+
+uint64_t nodeKey(uint64_t boardHash, int type, int depth, uint64_t preview) {
+    return mix64(boardHash ^ mix64(preview << 16 | (uint64_t)(type * 64 + depth + 1))) | 1;
+}
+
+// Whether some type can be placed twice within the next `count` pieces, counting the
+// `placed` ones. A node can only be reached again by swapping two pieces of one type
+// above it, so where this is false for every piece but the last, the subtree has nothing
+// to find in the table and its boards aren't hashed.
+bool mayRepeat(unsigned placed, uint64_t preview, int count) {
+    if (count > previewCount(preview)) return true; // An unseen piece can be any type
+    for (int i = 0; i < count; i++, preview = previewRest(preview)) {
+        unsigned bit = 1u << previewFront(preview);
+        if (placed & bit) return true;
+        placed |= bit;
+    }
+    return false;
+}
+
+// Prefetches every entry the next level will probe, so the table's cache misses overlap
+// instead of stalling one after another
+void prefetchChildren(const AiChild* children, int count, int depth, uint64_t preview, TranspositionTable* table) {
+    for (int i = 0; i < count; i++) {
+        if (previewCount(preview) > 0) {
+            table->prefetch(nodeKey(children[i].hash, previewFront(preview), depth, previewRest(preview)));
+        } else {
+            for (int t = 0; t < AI_PIECE_TYPES; t++) table->prefetch(nodeKey(children[i].hash, t, depth, 0));
+        }
+    }
+}
+
+// Last piece before the horizon: each placement is scored as soon as it is locked, without
+// expanding an array of children. Boards here aren't looked up: one repeats only when this
+// piece swaps with an earlier one of its type, too rarely for a lookup to cost less than
+// scoring the board.
+float horizonValue(const AiBoard& board, int type, SearchContext& context) {
+    AiBoard after;
+    float best = AI_LOST;
+    forEachPlacement(board, type, [&](int, const AiRotation& rotation, int x, int y) {
+        float score = lockPiece(board, rotation, x, y, after);
+        context.stats.evaluations++;
+        best = std::max(best, score + AiSearch::evaluate(after));
+    });
+    return best;
+}
+
+float nodeValue(const AiChild& node, int type, int depth, uint64_t preview, SearchContext& context);
+
+// Value of the child's board with `depth` pieces still to come: the next known piece
+// if the preview has one, otherwise the average over all seven
+float expectedValue(const AiChild& child, int depth, uint64_t preview, SearchContext& context) {
+    if (depth == 0) {
+        context.stats.evaluations++;
+        return AiSearch::evaluate(child.board);
+    }
+    if (previewCount(preview) > 0) {
+        return nodeValue(child, previewFront(preview), depth, previewRest(preview), context);
+    }
+    float value = 0;
+    for (int t = 0; t < AI_PIECE_TYPES; t++) {
+        value += nodeValue(child, t, depth, 0, context);
+    }
+    return value / AI_PIECE_TYPES;
+}
+
+// Best score for placing `type` on the child's board, followed by depth - 1 pieces:
+// the known ones from `preview`, then unseen ones
+float nodeValue(const AiChild& node, int type, int depth, uint64_t preview, SearchContext& context) {
+    TranspositionTable* table = context.table;
+    // Within a search, another path to this board has to place the same pieces in another
+    // order, so the table is only worth a probe once some type has come up twice (a line
+    // clear can merge other paths too, too rarely to pay for probing every node). Searches
+    // don't share positions either: the next one starts a piece deeper with the same depth.
+    bool shared = table && context.repeatedType;
+    float value;
+    uint64_t key = shared ? nodeKey(node.hash, type, depth, preview) : 0;
+    if (shared && table->probe(key, depth, value, context.stats.table)) return value;
+    context.stats.nodes++;
+    
+    if (depth == 1) {
+        value = horizonValue(node.board, type, context);
+    } else {
+        unsigned placedBefore = context.placedTypes;
+        bool repeatedBefore = context.repeatedType;
+        context.repeatedType |= (placedBefore >> type & 1) != 0;
+        context.placedTypes |= 1u << type;
+        bool hashed = table && (context.repeatedType || mayRepeat(context.placedTypes, preview, depth - 2));
+        AiChild children[AI_MAX_CHILDREN];
+        int count = expand(node.board, type, children, hashed ? &node.hash : nullptr);
+        if (table && context.repeatedType) prefetchChildren(children, count, depth - 1, preview, table);
+        value = AI_LOST;
+        for (int i = 0; i < count; i++) {
+            value = std::max(value, children[i].score + expectedValue(children[i], depth - 1, preview, context));
+        }
+        context.placedTypes = placedBefore;
+        context.repeatedType = repeatedBefore;
+    }
+    if (shared) table->store(key, depth, value, context.stats.table);
+    return value;
+}
+
+}
+
+bool AiBoard::fromGame(const TetrisGame& game, AiBoard& out) {
+    if (game.getBoardWidth() > AI_MAX_WIDTH || game.getBoardHeight() > AI_MAX_HEIGHT) return false;
+    out.width = game.getBoardWidth();
+    out.height = game.getBoardHeight();
+    for (int y = 0; y < out.height; y++) {
+        out.rows[y] = 0;
+        for (int x = 0; x < out.width; x++) {
+            if (game.getCell(x, y) != 0) out.rows[y] |= 1u << x;
+        }
+    }
+    return true;
+}
+
+int AiBoard::stackTop() const {
+    int y = 0;
+    while (y < height && rows[y] == 0) y++;
+    return y;
+}
+
+uint64_t AiBoard::hash() const {
+    uint64_t h = mix64((uint64_t)width << 48 | (uint64_t)height << 40); // Row keys have y below bit 38
+    for (int y = stackTop(); y < height; y++) h ^= rowHash(y, rows[y]);
+    return h;
+}
+
+bool AiBoard::operator==(const AiBoard& other) const {
+    return width == other.width && height == other.height &&
+           std::memcmp(rows, other.rows, sizeof(uint32_t) * height) == 0;
+}
+
+AiSearch::AiSearch(TranspositionTable* table, int threads)
+    : table(table), threads(std::max(1, threads)), jobRound(0), helpersBusy(0), quitting(false) {
+    for (int index = 1; index < this->threads; index++) helpers.emplace_back(&AiSearch::helperLoop, this, index);
+}
+
+AiSearch::~AiSearch() {
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        quitting = true;
+    }
+    jobReady.notify_all();
+    for (std::thread& helper : helpers) helper.join();
+}
+
+// Helpers sleep between searches and run each new job once, with their own index
+void AiSearch::helperLoop(int index) {
+    uint64_t seenRound = 0;
+    std::unique_lock<std::mutex> lock(poolMutex);
+    for (;;) {
+        jobReady.wait(lock, [&] { return quitting || jobRound != seenRound; });
+        if (quitting) return;
+        seenRound = jobRound;
+        lock.unlock();
+        job(index);
+        lock.lock();
+        if (--helpersBusy == 0) jobDone.notify_one();
+    }
+}
+
+AiMove AiSearch::findMove(const AiBoard& board, int current, int next, int depth) {
+    return findMove(board, current, &next, 1, depth);
+}
+
+AiMove AiSearch::findMove(const AiBoard& board, int current, const int* preview, int previewLength, int depth) {
+    TRACE_ZONE("findMove");
+    // Only the pieces the search reaches matter, dropping the rest lets more positions share table entries
+    uint64_t known = packPreview(preview, std::max(0, std::min({previewLength, depth - 1, PIECE_PREVIEW_MAX})));
+    AiChild roots[AI_MAX_CHILDREN];
+    float values[AI_MAX_CHILDREN];
+    bool hashed = table && mayRepeat(1u << current, known, depth - 2);
+    uint64_t boardHash = hashed ? board.hash() : 0;
+    int count = expand(board, current, roots, hashed ? &boardHash : nullptr);
+    
+    stats = AiSearchStats();
+    if (table) table->newSearch();
+    
+    // Each thread takes the next unsearched root placement until none are left
+    std::atomic<int> nextRoot(0);
+    std::vector<SearchContext> contexts(threads);
+    for (int w = 0; w < threads; w++) {
+        contexts[w].table = table;
+        contexts[w].placedTypes = 1u << current;
+    }
+    auto work = [&](int worker) {
+        for (int i = nextRoot++; i < count; i = nextRoot++) {
+            values[i] = roots[i].score + expectedValue(roots[i], depth - 1, known, contexts[worker]);
+        }
+    };
+    if (!helpers.empty()) {
+        {
+            std::lock_guard<std::mutex> lock(poolMutex);
+            job = work;
+            helpersBusy = (int)helpers.size();
+            jobRound++;
+        }
+        jobReady.notify_all();
+    }
+    work(0);
+    if (!helpers.empty()) {
+        std::unique_lock<std::mutex> lock(poolMutex);
+        jobDone.wait(lock, [&] { return helpersBusy == 0; });
+    }
+    for (const SearchContext& context : contexts) stats.add(context.stats);
+    if (table) table->addStats(stats.table);
+    
+    // Lowest placement index wins ties, so the choice doesn't depend on thread timing
+    AiMove best;
+    for (int i = 0; i < count; i++) {
+        if (!best.valid || values[i] > best.value) {
+            best.valid = true;
+            best.rotations = roots[i].rotations;
+            best.x = roots[i].x;
+            best.value = values[i];
+        }
+    }
+    return best;
+}
+
+bool AiSearch::apply(const AiBoard& board, int type, const AiMove& move, AiBoard& out) {
+    const AiPiece& piece = pieces()[type];
+    int spawnX = board.width / 2 - 2;
+    if (!move.valid || move.rotations < 0 || move.rotations > 3) return false;
+    for (int r = 0; r <= move.rotations; r++) {
+        if (!fits(board, piece.rotations[r], spawnX, 0)) return false;
+    }
+    const AiRotation& rotation = piece.rotations[move.rotations];
+    int step = move.x < spawnX ? -1 : 1;
+    for (int x = spawnX; x != move.x; x += step) {
+        if (!fits(board, rotation, x + step, 0)) return false;
+    }
+    int tops[AI_MAX_WIDTH];
+    columnTops(board, tops);
+    lockPiece(board, rotation, move.x, landingRow(board, rotation, move.x, tops), out);
+    return true;
+}
+
+float AiSearch::evaluate(const AiBoard& board) {
+    int width = board.width;
+    uint64_t full = fullRow(width);
+    uint64_t walls = 1 | 1ull << (width + 1);
+    uint64_t boundaries = (1ull << (width + 1)) - 1;
+    int rowTransitions = 0, columnTransitions = 0, holes = 0, wells = 0;
+    uint64_t above = 0, covered = 0, wellRuns = 0;
+    int wellDepth[AI_MAX_WIDTH];
+    for (int y = board.stackTop(); y < board.height; y++) {
+        uint64_t row = board.rows[y];
+        
+        // Walls and the floor count as filled
+        uint64_t walled = row << 1 | walls;
+        rowTransitions += popcount((walled ^ (walled >> 1)) & boundaries);
+        columnTransitions += popcount(row ^ above);
+        holes += popcount(~row & covered & full);
+        
+        // Empty cells with both neighbours filled, each scored by its depth in the well
+        uint64_t wellCells = ~row & (row << 1 | 1) & (row >> 1 | 1ull << (width - 1)) & full;
+        for (uint64_t started = wellCells & ~wellRuns; started; started &= started - 1) {
+            wellDepth[__builtin_ctzll(started)] = 0;
+        }
+        for (uint64_t cells = wellCells; cells; cells &= cells - 1) {
+            wells += ++wellDepth[__builtin_ctzll(cells)];
+        }
+        wellRuns = wellCells;
+        above = row;
+        covered |= row;
+    }
+    columnTransitions += popcount(~above & full);
+    return WEIGHT_ROW_TRANSITIONS * rowTransitions + WEIGHT_COLUMN_TRANSITIONS * columnTransitions +
+           WEIGHT_HOLES * holes + WEIGHT_WELLS * wells;
+}
@@ -0,0 +1,249 @@
+#include "headers/BotProcess.h"
+#include <chrono>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <algorithm>
+#include <mutex>
+#else
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+BotProcess::~BotProcess() {
+    stop();
+}
+
+#ifndef _WIN32
+
+BotProcess::BotProcess() : pid(-1), toBot(-1), fromBot(-1) {
+}
+
+// Close-on-exec pipe, so bots started in parallel don't inherit each other's ends
+static bool makePipe(int ends[2]) {
+#ifdef __linux__
+    return pipe2(ends, O_CLOEXEC) == 0;
+#else
+    if (pipe(ends) != 0) return false;
+    fcntl(ends[0], F_SETFD, FD_CLOEXEC);
+    fcntl(ends[1], F_SETFD, FD_CLOEXEC);
+    return true;
+#endif
+}
+
+bool BotProcess::start(const std::string& command) {
+    stop();
+    
+    int input[2], output[2];
+    if (!makePipe(input)) return false;
+    if (!makePipe(output)) {
+        close(input[0]);
+        close(input[1]);
+        return false;
+    }
+    
+    pid = fork();
+    if (pid == 0) {
+        // Child: only async-signal-safe calls until exec
+        dup2(input[0], STDIN_FILENO);
+        dup2(output[1], STDOUT_FILENO);
+        execl("/bin/sh", "sh", "-c", command.c_str(), (char*)nullptr);
+        _exit(127);
+    }
+    close(input[0]);
+    close(output[1]);
+    if (pid < 0) {
+        close(input[1]);
+        close(output[0]);
+        return false;
+    }
+    toBot = input[1];
+    fromBot = output[0];
+    pending.clear();
+    return true;
+}
+
+void BotProcess::stop() {
+    if (toBot >= 0) close(toBot);
+    if (fromBot >= 0) close(fromBot);
+    toBot = fromBot = -1;
+    if (pid <= 0) return;
+    
+    // A well-behaved bot exits on end of input
+    for (int i = 0; i < 20; i++) {
+        if (waitpid(pid, nullptr, WNOHANG) == pid) {
+            pid = -1;
+            return;
+        }
+        usleep(10000);
+    }
+    kill(pid, SIGKILL);
+    waitpid(pid, nullptr, 0);
+    pid = -1;
+}
+
+bool BotProcess::sendLine(const std::string& line) {
+    std::string message = line + "\n";
+    size_t written = 0;
+    while (written < message.size()) {
+        ssize_t result = write(toBot, message.data() + written, message.size() - written);
+        if (result < 0) {
+            if (errno == EINTR) continue;
+            return false; // EPIPE once the bot has exited (the arena ignores SIGPIPE)
+        }
+        written += result;
+    }
+    return true;
+}
+
+BotProcess::ReadResult BotProcess::readLine(std::string& line, int timeoutMs) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    for (;;) {
+        size_t end = pending.find('\n');
+        if (end != std::string::npos) {
+            line.assign(pending, 0, end);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            pending.erase(0, end + 1);
+            return Line;
+        }
+        
+        // Round up, poll() would otherwise return just before the deadline
+        long long micros = std::chrono::duration_cast<std::chrono::microseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (micros <= 0) return Timeout;
+        int remaining = (int)((micros + 999) / 1000);
+        pollfd waitFor = {fromBot, POLLIN, 0};
+        int ready = poll(&waitFor, 1, remaining);
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready == 0) return Timeout;
+        
+        char buffer[4096];
+        ssize_t received = read(fromBot, buffer, sizeof(buffer));
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) return Closed;
+        pending.append(buffer, received);
+    }
+}
+
+#else
+
+BotProcess::BotProcess() : process(nullptr), toBot(INVALID_HANDLE_VALUE), fromBot(INVALID_HANDLE_VALUE) {
+}
+
+static void closeHandle(void*& handle) {
+    if (handle != INVALID_HANDLE_VALUE) CloseHandle(handle);
+    handle = INVALID_HANDLE_VALUE;
+}
+
+bool BotProcess::start(const std::string& command) {
+    stop();
+    
+    // The child's pipe ends have to be inheritable while CreateProcess runs, so a bot
+    // started from another thread in that window would inherit them too and keep our
+    // pipes open after this bot exits. Starting one bot at a time rules that out.
+    static std::mutex startLock;
+    std::lock_guard<std::mutex> lock(startLock);
+    
+    SECURITY_ATTRIBUTES inheritable = {sizeof(SECURITY_ATTRIBUTES), NULL, TRUE};
+    HANDLE inputRead, inputWrite, outputRead, outputWrite;
+    if (!CreatePipe(&inputRead, &inputWrite, &inheritable, 0)) return false;
+    if (!CreatePipe(&outputRead, &outputWrite, &inheritable, 0)) {
+        CloseHandle(inputRead);
+        CloseHandle(inputWrite);
+        return false;
+    }
+    // Our ends stay in this process
+    SetHandleInformation(inputWrite, HANDLE_FLAG_INHERIT, 0);
+    SetHandleInformation(outputRead, HANDLE_FLAG_INHERIT, 0);
+    
+    STARTUPINFOA startup;
+    ZeroMemory(&startup, sizeof(startup));
+    startup.cb = sizeof(startup);
+    startup.dwFlags = STARTF_USESTDHANDLES;
+    startup.hStdInput = inputRead;
+    startup.hStdOutput = outputWrite;
+    startup.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+    
+    // CreateProcessA may write to the command line, so it gets its own copy
+    std::string commandLine = command;
+    PROCESS_INFORMATION info;
+    BOOL created = CreateProcessA(NULL, &commandLine[0], NULL, NULL, TRUE, 0, NULL, NULL, &startup, &info);
+    CloseHandle(inputRead);
+    CloseHandle(outputWrite);
+    if (!created) {
+        CloseHandle(inputWrite);
+        CloseHandle(outputRead);
+        return false;
+    }
+    CloseHandle(info.hThread);
+    process = info.hProcess;
+    toBot = inputWrite;
+    fromBot = outputRead;
+    pending.clear();
+    return true;
+}
+
+void BotProcess::stop() {
+    closeHandle(toBot);
+    closeHandle(fromBot);
+    if (!process) return;
+    
+    // A well-behaved bot exits on end of input
+    if (WaitForSingleObject(process, 200) != WAIT_OBJECT_0) {
+        TerminateProcess(process, 1);
+        WaitForSingleObject(process, INFINITE);
+    }
+    CloseHandle(process);
+    process = nullptr;
+}
+
+bool BotProcess::sendLine(const std::string& line) {
+    std::string message = line + "\n";
+    size_t written = 0;
+    while (written < message.size()) {
+        DWORD result;
+        if (!WriteFile(toBot, message.data() + written, (DWORD)(message.size() - written), &result, NULL)) {
+            return false; // ERROR_NO_DATA once the bot has exited
+        }
+        written += result;
+    }
+    return true;
+}
+
+BotProcess::ReadResult BotProcess::readLine(std::string& line, int timeoutMs) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    int idlePolls = 0;
+    for (;;) {
+        size_t end = pending.find('\n');
+        if (end != std::string::npos) {
+            line.assign(pending, 0, end);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            pending.erase(0, end + 1);
+            return Line;
+        }
+        
+        // Anonymous pipes can't wait with a timeout, so poll how much is buffered
+        DWORD available = 0;
+        if (!PeekNamedPipe(fromBot, NULL, 0, NULL, &available, NULL)) return Closed; // ERROR_BROKEN_PIPE
+        if (available == 0) {
+            if (std::chrono::steady_clock::now() >= deadline) return Timeout;
+            // Yield first, most replies come quickly; Sleep(1) can take a whole timer tick
+            Sleep(idlePolls++ < 100 ? 0 : 1);
+            continue;
+        }
+        
+        char buffer[4096];
+        DWORD received;
+        if (!ReadFile(fromBot, buffer, std::min<DWORD>(available, sizeof(buffer)), &received, NULL) || received == 0) {
+            return Closed;
+        }
+        pending.append(buffer, received);
+    }
+}
+
+#endif
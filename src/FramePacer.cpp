@@ -0,0 +1,43 @@
+#include "headers/FramePacer.h"
+#include <algorithm>
+#include <thread>
+
+FramePacer::FramePacer(int maxFps) : frameLength(0), spinMargin(std::chrono::milliseconds(1)), lastFrame(Clock::now()) {
+    setMaxFps(maxFps);
+}
+
+void FramePacer::setMaxFps(int maxFps) {
+    if (maxFps > 0) {
+        frameLength = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / maxFps));
+    } else {
+        frameLength = Clock::duration::zero();
+    }
+}
+
+void FramePacer::waitForNextFrame() {
+    Clock::time_point deadline = lastFrame + frameLength;
+    Clock::time_point current = Clock::now();
+    
+    if (frameLength > Clock::duration::zero() && deadline > current) {
+        // Sleep until just before the deadline, then learn from how late we woke up
+        if (deadline - current > spinMargin) {
+            Clock::time_point wakeTarget = deadline - spinMargin;
+            std::this_thread::sleep_until(wakeTarget);
+            Clock::duration oversleep = Clock::now() - wakeTarget;
+            // Jump to a late wakeup, decay back when sleeps are accurate
+            if (oversleep > spinMargin) {
+                spinMargin = oversleep;
+            } else {
+                spinMargin -= spinMargin / 8;
+            }
+            // Never spin more than half a frame, one pathological wakeup shouldn't pin a core
+            spinMargin = std::max<Clock::duration>(std::chrono::microseconds(200), std::min(spinMargin, frameLength / 2));
+        }
+        while (Clock::now() < deadline) {
+            std::this_thread::yield();
+        }
+        lastFrame = deadline; // Stay on the fixed cadence
+        return;
+    }
+    lastFrame = current;
+}
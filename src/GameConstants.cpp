@@ -13,7 +13,7 @@ const Color COLORS[] = {
 };
 
 // Tetris piece shapes
-const std::vector<std::vector<std::vector<int>>> PIECES = {
+const int PIECES[7][4][4] = {
     // I-piece
     {
         {0,0,0,0},
@@ -0,0 +1,305 @@
+#include "headers/LockstepEngine.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LOCKSTEP_SSE2 1
+#endif
+
+static_assert(BOARD_WIDTH + 2 * LOCKSTEP_WALL <= 16, "Rows are 16-bit masks");
+static_assert(BOARD_HEIGHT + 4 <= LOCKSTEP_ROW_STRIDE, "Every piece position must have 4 rows to test");
+
+static const uint16_t FULL_ROW = 0xffff;
+static const uint16_t EMPTY_ROW = (uint16_t)~(((1u << BOARD_WIDTH) - 1) << LOCKSTEP_WALL); // Only the walls
+static const uint64_t LANE_LOW = 0x7fff7fff7fff7fffull;  // Four 16-bit lanes without their top bit
+static const uint64_t LANE_HIGH = 0x8000800080008000ull; // Top bit of each lane
+
+namespace {
+
+// Piece masks for every type, rotation and box column: four 16-bit rows in the same
+// layout as four consecutive board rows loaded as one 64-bit word
+struct PieceMasks {
+    uint64_t masks[7][4][16]; // [type][rotation][x + LOCKSTEP_WALL]
+    uint64_t expand[256];     // 8 cells of a row as 8 bytes of 0/1
+    
+    PieceMasks() {
+        for (int t = 0; t < 7; t++) {
+            TetrisPiece piece(t);
+            for (int r = 0; r < 4; r++) {
+                for (int column = 0; column < 16; column++) {
+                    uint16_t pieceRows[4] = {0, 0, 0, 0};
+                    bool outside = false;
+                    for (int i = 0; i < 4; i++) {
+                        for (int j = 0; j < 4; j++) {
+                            if (piece.shape[i][j] == 0) continue;
+                            if (column + j >= 16) outside = true;
+                            else pieceRows[i] |= (uint16_t)(1u << (column + j));
+                        }
+                    }
+                    uint64_t& mask = masks[t][r][column];
+                    std::memcpy(&mask, pieceRows, sizeof(mask));
+                    if (outside) mask = ~0ull; // Past the right wall, collides with anything
+                }
+                piece.rotate();
+            }
+        }
+        for (int b = 0; b < 256; b++) {
+            uint8_t bytes[8];
+            for (int k = 0; k < 8; k++) bytes[k] = (b >> k) & 1;
+            std::memcpy(&expand[b], bytes, sizeof(bytes));
+        }
+    }
+};
+
+const PieceMasks& pieceMasks() {
+    static const PieceMasks table;
+    return table;
+}
+
+inline uint64_t pieceMask(int pieceType, int pieceRotation, int x) {
+    unsigned column = (unsigned)(x + LOCKSTEP_WALL);
+    return column < 16 ? pieceMasks().masks[pieceType][pieceRotation][column] : ~0ull;
+}
+
+// Top bit of every 16-bit lane that isn't zero
+inline uint64_t nonzeroLanes(uint64_t lanes) {
+    return (((lanes & LANE_LOW) + LANE_LOW) | lanes) & LANE_HIGH;
+}
+
+// Same expression as TetrisGame, so gravity fires on exactly the same ticks
+inline double fallSpeedFor(int lines) {
+    return std::max(0.1, 1.0 - lines * 0.05);
+}
+
+// The piece move each action tries: one position test, taken if it's free. A hard
+// drop moves nothing here and is queued for dropPiece().
+struct ActionMove {
+    int8_t dx, turn, dy, points, drop;
+};
+
+const ActionMove ACTION_MOVES[LOCKSTEP_HARD_DROP + 1] = {
+    {0, 0, 0, 0, 0},  // None
+    {-1, 0, 0, 0, 0}, // Left
+    {1, 0, 0, 0, 0},  // Right
+    {0, 1, 0, 0, 0},  // Rotate
+    {0, 0, 1, 1, 0},  // Soft drop, a point per row
+    {0, 0, 0, 0, 1},  // Hard drop
+};
+
+}
+
+LockstepEngine::LockstepEngine(int count, uint64_t seed, int32_t ticksPerStep, int previewDepth, Randomizer randomizer)
+    : count(count), ticksPerStep(ticksPerStep), rows((size_t)count * LOCKSTEP_ROW_STRIDE), type(count), rotation(count),
+      pieceX(count), pieceY(count), fallIn(count), score(count), over(count), lines(count), tick(count),
+      lastFallTick(count), scoreBefore(count), dropping(count) {
+    queues.reserve(count);
+    for (int i = 0; i < count; i++) {
+        queues.emplace_back(seedFor(seed, i), previewDepth, randomizer);
+        restart(i);
+    }
+}
+
+uint64_t LockstepEngine::collides(int game, int pieceType, int pieceRotation, int x, int y) const {
+    uint64_t block;
+    std::memcpy(&block, &rows[(size_t)game * LOCKSTEP_ROW_STRIDE + y], sizeof(block));
+    return block & pieceMask(pieceType, pieceRotation, x);
+}
+
+void LockstepEngine::spawn(int game) {
+    type[game] = (uint8_t)queues[game].pop();
+    rotation[game] = 0;
+    pieceX[game] = BOARD_WIDTH / 2 - 2;
+    pieceY[game] = 0;
+    if (collides(game, type[game], 0, pieceX[game], 0)) over[game] = 1;
+}
+
+void LockstepEngine::restart(int game) {
+    uint16_t* board = &rows[(size_t)game * LOCKSTEP_ROW_STRIDE];
+    std::fill(board, board + BOARD_HEIGHT, EMPTY_ROW);
+    std::fill(board + BOARD_HEIGHT, board + LOCKSTEP_ROW_STRIDE, FULL_ROW); // Floor
+    score[game] = 0;
+    lines[game] = 0;
+    over[game] = 0;
+    lastFallTick[game] = tick[game];
+    spawn(game);
+    scheduleFall(game);
+}
+
+// First tick at which TetrisGame::update() would see currentTime - lastFall > fallSpeed
+void LockstepEngine::scheduleFall(int game) {
+    double fallSpeed = fallSpeedFor(lines[game]);
+    double lastFall = (double)lastFallTick[game] / SIM_TICKS_PER_SECOND;
+    uint64_t fireTick = lastFallTick[game] + (uint64_t)(fallSpeed * SIM_TICKS_PER_SECOND) - 1;
+    while ((double)fireTick / SIM_TICKS_PER_SECOND - lastFall <= fallSpeed) fireTick++;
+    fallIn[game] = (int32_t)std::max<int64_t>((int64_t)(fireTick - tick[game]), 1);
+}
+
+void LockstepEngine::lockPiece(int game) {
+    uint16_t* board = &rows[(size_t)game * LOCKSTEP_ROW_STRIDE];
+    int y = pieceY[game];
+    uint64_t mask = pieceMask(type[game], rotation[game], pieceX[game]);
+    uint64_t block;
+    std::memcpy(&block, board + y, sizeof(block));
+    block |= mask;
+    std::memcpy(board + y, &block, sizeof(block));
+    
+    // Only rows the piece touched can have filled up (the floor rows are always full):
+    // those are the lanes of the block with no empty cell and some piece cell
+    uint64_t fullRows = nonzeroLanes(mask) & ~nonzeroLanes(~block);
+    int cleared = 0, lowest = -1;
+    for (int i = 0; fullRows != 0 && i < 4; i++) {
+        if ((fullRows >> (16 * i + 15)) & 1) {
+            cleared++;
+            lowest = y + i;
+        }
+    }
+    if (cleared > 0) {
+        int write = lowest;
+        for (int read = lowest; read >= 0; read--) {
+            if (board[read] != FULL_ROW) board[write--] = board[read];
+        }
+        for (; write >= 0; write--) board[write] = EMPTY_ROW;
+        lines[game] += cleared;
+        score[game] += cleared * cleared * 100;
+        scheduleFall(game); // Faster gravity, same last fall
+    }
+    spawn(game);
+}
+
+// Moves the piece as far down as it goes and locks it
+void LockstepEngine::dropPiece(int game) {
+    const uint16_t* board = &rows[(size_t)game * LOCKSTEP_ROW_STRIDE];
+    uint64_t mask = pieceMask(type[game], rotation[game], pieceX[game]);
+    int y = pieceY[game];
+#ifdef LOCKSTEP_SSE2
+    // Eight drops per test: piece row i against board rows y + 1 + i .. y + 8 + i. The
+    // floor stops the piece before a load can pass the game's LOCKSTEP_ROW_STRIDE rows.
+    uint16_t pieceRows[4];
+    std::memcpy(pieceRows, &mask, sizeof(pieceRows));
+    const __m128i zero = _mm_setzero_si128();
+    for (;;) {
+        __m128i hits = zero;
+        for (int i = 0; i < 4; i++) {
+            __m128i below = _mm_loadu_si128((const __m128i*)(board + y + 1 + i));
+            hits = _mm_or_si128(hits, _mm_and_si128(below, _mm_set1_epi16((short)pieceRows[i])));
+        }
+        unsigned blocked = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi16(hits, zero)) ^ 0xffff; // 2 bits a drop
+        if (blocked != 0) {
+            for (; (blocked & 3) == 0; blocked >>= 2) y++;
+            break;
+        }
+        y += 8;
+    }
+#else
+    uint64_t block;
+    for (;;) {
+        std::memcpy(&block, board + y + 1, sizeof(block));
+        if (block & mask) break;
+        y++;
+    }
+#endif
+    pieceY[game] = (int8_t)y;
+    lockPiece(game);
+}
+
+// TetrisGame::update() for `ticks` ticks, jumping straight to the ticks where gravity fires
+void LockstepEngine::runGravity(int game, int32_t ticks) {
+    while (ticks > 0 && !over[game]) {
+        if (fallIn[game] > ticks) {
+            fallIn[game] -= ticks;
+            tick[game] += ticks;
+            return;
+        }
+        tick[game] += fallIn[game];
+        ticks -= fallIn[game];
+        if (!collides(game, type[game], rotation[game], pieceX[game], pieceY[game] + 1)) {
+            pieceY[game]++;
+        } else {
+            lockPiece(game);
+        }
+        lastFallTick[game] = tick[game];
+        scheduleFall(game);
+    }
+}
+
+void LockstepEngine::restartAll() {
+    for (int i = 0; i < count; i++) restart(i);
+}
+
+void LockstepEngine::step(const int32_t* actions, float* rewards, uint8_t* dones) {
+    // Actions: one 64-bit test against the game's own rows, applied without branching
+    // on the action (random actions would mispredict), hard drops queued for after
+    int drops = 0;
+    for (int i = 0; i < count; i++) {
+        scoreBefore[i] = score[i];
+        unsigned action = (unsigned)actions[i];
+        const ActionMove& move = ACTION_MOVES[action <= LOCKSTEP_HARD_DROP ? action : (unsigned)LOCKSTEP_NONE];
+        int x = pieceX[i] + move.dx, turned = (rotation[i] + move.turn) & 3, y = pieceY[i] + move.dy;
+        bool free = collides(i, type[i], turned, x, y) == 0;
+        pieceX[i] = (int8_t)(free ? x : pieceX[i]);
+        rotation[i] = (uint8_t)(free ? turned : rotation[i]);
+        pieceY[i] = (int8_t)(free ? y : pieceY[i]);
+        score[i] += free ? move.points : 0;
+        dropping[drops] = i;
+        drops += move.drop;
+    }
+    for (int k = 0; k < drops; k++) dropPiece(dropping[k]);
+    
+    // Gravity: most lanes only count down, the few whose timer expires run the full rules
+    int i = 0;
+#ifdef LOCKSTEP_SSE2
+    const __m128i stepTicks = _mm_set1_epi32(ticksPerStep);
+    const __m128i stepTicks64 = _mm_set1_epi64x(ticksPerStep);
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 4 <= count; i += 4) {
+        __m128i timers = _mm_loadu_si128((const __m128i*)&fallIn[i]);
+        int32_t overBytes;
+        std::memcpy(&overBytes, &over[i], sizeof(overBytes));
+        __m128i ended = _mm_cmpgt_epi32(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(overBytes), zero), zero), zero);
+        __m128i quiet = _mm_andnot_si128(ended, _mm_cmpgt_epi32(timers, stepTicks));
+        if (_mm_movemask_epi8(quiet) == 0xffff) {
+            _mm_storeu_si128((__m128i*)&fallIn[i], _mm_sub_epi32(timers, stepTicks));
+            __m128i* ticks = (__m128i*)&tick[i];
+            _mm_storeu_si128(ticks, _mm_add_epi64(_mm_loadu_si128(ticks), stepTicks64));
+            _mm_storeu_si128(ticks + 1, _mm_add_epi64(_mm_loadu_si128(ticks + 1), stepTicks64));
+            continue;
+        }
+        for (int lane = i; lane < i + 4; lane++) runGravity(lane, ticksPerStep);
+    }
+#endif
+    for (; i < count; i++) runGravity(i, ticksPerStep);
+    
+    // Ended games are reported, then restarted in place
+    for (i = 0; i < count; i++) {
+        rewards[i] = (float)(score[i] - scoreBefore[i]);
+        dones[i] = over[i];
+        if (over[i]) restart(i);
+    }
+}
+
+void LockstepEngine::writeBoard(int game, uint8_t* locked, uint8_t* falling) const {
+    const uint64_t* expand = pieceMasks().expand;
+    const uint16_t* board = &rows[(size_t)game * LOCKSTEP_ROW_STRIDE];
+    for (int y = 0; y < BOARD_HEIGHT; y++) {
+        unsigned cells = (unsigned)(board[y] >> LOCKSTEP_WALL) & ((1u << BOARD_WIDTH) - 1);
+        uint8_t* out = locked + y * BOARD_WIDTH;
+        for (int x = 0; x < BOARD_WIDTH; x += 8, cells >>= 8) {
+            std::memcpy(out + x, &expand[cells & 0xff], std::min(8, BOARD_WIDTH - x));
+        }
+    }
+    
+    std::memset(falling, 0, BOARD_WIDTH * BOARD_HEIGHT);
+    uint16_t pieceRows[4];
+    uint64_t mask = pieceMask(type[game], rotation[game], pieceX[game]);
+    std::memcpy(pieceRows, &mask, sizeof(pieceRows));
+    for (int i = 0; i < 4; i++) {
+        int y = pieceY[game] + i;
+        if (y >= BOARD_HEIGHT) break;
+        unsigned cells = (unsigned)(pieceRows[i] >> LOCKSTEP_WALL) & ((1u << BOARD_WIDTH) - 1);
+        uint8_t* out = falling + y * BOARD_WIDTH;
+        for (int x = 0; x < BOARD_WIDTH; x += 8, cells >>= 8) {
+            std::memcpy(out + x, &expand[cells & 0xff], std::min(8, BOARD_WIDTH - x));
+        }
+    }
+}
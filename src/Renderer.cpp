@@ -1,7 +1,10 @@
 #include "headers/Renderer.h"
 #include <GLFW/glfw3.h>
+#include <algorithm>
+#include "headers/Trace.h"
 
-Renderer::Renderer() : blockShaderProgram(0), uiShaderProgram(0), VAO(0), VBO(0) {
+Renderer::Renderer() : blockShaderProgram(0), uiShaderProgram(0), VAO(0), VBO(0),
+                       cellSize(BLOCK_SIZE), viewRows(BOARD_HEIGHT) {
     initOpenGL();
 }
 
@@ -348,14 +351,221 @@ void Renderer::drawNumber(int number, float x, float y, float size, const Color&
 
 void Renderer::drawBlock(int x, int y, const Color& color) {
     glUseProgram(blockShaderProgram);
-    float screenX = x * BLOCK_SIZE + BOARD_OFFSET_X;
-    float screenY = (BOARD_HEIGHT - y - 1) * BLOCK_SIZE + BOARD_OFFSET_Y;
+    float screenX = x * cellSize + BOARD_OFFSET_X;
+    float screenY = (viewRows - y - 1) * cellSize + BOARD_OFFSET_Y;
     GLint offsetLoc = glGetUniformLocation(blockShaderProgram, "offset");
     glUniform2f(offsetLoc, screenX, screenY);
     GLint scaleLoc = glGetUniformLocation(blockShaderProgram, "scale");
-    glUniform2f(scaleLoc, BLOCK_SIZE - 1, BLOCK_SIZE - 1);
+    glUniform2f(scaleLoc, std::max(1, cellSize - 1), std::max(1, cellSize - 1));
     GLint colorLoc = glGetUniformLocation(blockShaderProgram, "color");
     glUniform4f(colorLoc, color.r, color.g, color.b, color.a);
     glBindVertexArray(VAO);
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
 }
+
+
+void Renderer::drawGame(const GameSnapshot& state) {
+    TRACE_ZONE("render");
+    glClear(GL_COLOR_BUFFER_BIT);
+    glClearColor(0.15f, 0.15f, 0.15f, 1.0f); // Darker background
+    
+    // Large boards are scaled down to fit and only the visible rows are drawn
+    cellSize = state.cellSize;
+    viewRows = state.viewRows;
+    int boardWidth = state.boardWidth;
+    
+    // Draw the game board
+    {
+        TRACE_ZONE("draw board");
+        for (int y = 0; y < viewRows; y++) {
+            const unsigned char* row = &state.board[(size_t)y * boardWidth];
+            for (int x = 0; x < boardWidth; x++) {
+                if (row[x] != 0) {
+                    drawBlock(x, y, COLORS[row[x]]);
+                }
+            }
+        }
+    }
+    
+    // Draw the ghost piece at the landing row
+    {
+        TRACE_ZONE("draw pieces");
+        if (!state.gameOver) {
+            int ghostY = state.ghostY;
+            for (int i = 0; i < 4; i++) {
+                for (int j = 0; j < 4; j++) {
+                    if (state.current[i][j] != 0) {
+                        int drawX = state.currentX + j;
+                        int drawY = ghostY + i;
+                        if (drawX >= 0 && drawX < boardWidth && drawY >= 0 && drawY < viewRows) {
+                            Color ghostColor = COLORS[state.current[i][j]];
+                            ghostColor.a = 0.25f;
+                            drawBlock(drawX, drawY, ghostColor);
+                        }
+                    }
+                }
+            }
+        }
+    
+        // Draw the current piece
+        if (!state.gameOver) {
+            for (int i = 0; i < 4; i++) {
+                for (int j = 0; j < 4; j++) {
+                    if (state.current[i][j] != 0) {
+                        int drawX = state.currentX + j;
+                        int drawY = state.currentY + i;
+                        if (drawX >= 0 && drawX < boardWidth && drawY >= 0 && drawY < viewRows) {
+                            drawBlock(drawX, drawY, COLORS[state.current[i][j]]);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    
+    // Draw game board border
+    {
+        TRACE_ZONE("draw border");
+        Color borderColor(0.7f, 0.7f, 0.7f, 1.0f);
+        int borderThickness = 3;
+        // Use UI shader for borders
+        int boardPixelsX = boardWidth * cellSize;
+        int boardPixelsY = viewRows * cellSize;
+        drawRect(BOARD_OFFSET_X - borderThickness, BOARD_OFFSET_Y - borderThickness, borderThickness, boardPixelsY + 2 * borderThickness, borderColor);
+        drawRect(BOARD_OFFSET_X + boardPixelsX, BOARD_OFFSET_Y - borderThickness, borderThickness, boardPixelsY + 2 * borderThickness, borderColor);
+        drawRect(BOARD_OFFSET_X - borderThickness, BOARD_OFFSET_Y - borderThickness, boardPixelsX + 2 * borderThickness, borderThickness, borderColor);
+        drawRect(BOARD_OFFSET_X - borderThickness, BOARD_OFFSET_Y + boardPixelsY, boardPixelsX + 2 * borderThickness, borderThickness, borderColor);
+    }
+    
+    // UI Panel settings
+    {
+        TRACE_ZONE("draw panels");
+        float panelX = BOARD_OFFSET_X + BOARD_WIDTH * BLOCK_SIZE + 20;
+        float panelWidth = 180;
+        Color panelBorder(1.0f, 1.0f, 1.0f, 1.0f); // White border only
+        Color textColor(1.0f, 1.0f, 1.0f, 1.0f); // White text
+        Color numberColor(1.0f, 1.0f, 1.0f, 1.0f); // White numbers
+
+        // Next piece panel: the next piece full size, the rest of the queue smaller below it
+        int queued = std::max(1, std::min(state.previewCount, PIECE_PREVIEW_MAX));
+        float nextPanelHeight = 100 + (queued - 1) * 36;
+        float nextPanelY = BOARD_OFFSET_Y + BOARD_HEIGHT * BLOCK_SIZE - 20 - nextPanelHeight;
+
+        // Draw only border (no fill) for UI panels
+        drawRect(panelX, nextPanelY, panelWidth, 3, panelBorder); // Top
+        drawRect(panelX, nextPanelY + nextPanelHeight - 3, panelWidth, 3, panelBorder); // Bottom
+        drawRect(panelX, nextPanelY, 3, nextPanelHeight, panelBorder); // Left
+        drawRect(panelX + panelWidth - 3, nextPanelY, 3, nextPanelHeight, panelBorder); // Right
+
+        // Draw "NEXT" title
+        drawText("NEXT", panelX + 10, nextPanelY + nextPanelHeight - 30, 18, textColor);
+
+        // Draw queue previews (use block shader for blocks)
+        for (int k = 0; k < queued; k++) {
+            int type = state.preview[k];
+            int previewSize = k == 0 ? 18 : 12;
+            float previewX = panelX + (k == 0 ? 60 : 72);
+            float previewY = k == 0 ? nextPanelY + 4 + (queued - 1) * 36 : nextPanelY - 4 + (queued - 1 - k) * 36;
+            for (int i = 0; i < 4; i++) {
+                for (int j = 0; j < 4; j++) {
+                    if (PIECES[type][i][j] != 0) {
+                        float blockX = previewX + j * previewSize;
+                        float blockY = previewY + (3 - i) * previewSize;
+                        glUseProgram(blockShaderProgram);
+                        GLint offsetLoc = glGetUniformLocation(blockShaderProgram, "offset");
+                        glUniform2f(offsetLoc, blockX, blockY);
+                        GLint scaleLoc = glGetUniformLocation(blockShaderProgram, "scale");
+                        glUniform2f(scaleLoc, previewSize - 2, previewSize - 2);
+                        GLint colorLoc = glGetUniformLocation(blockShaderProgram, "color");
+                        Color previewColor = COLORS[PIECES[type][i][j]];
+                        glUniform4f(colorLoc, previewColor.r, previewColor.g, previewColor.b, previewColor.a);
+                        glBindVertexArray(VAO);
+                        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+                    }
+                }
+            }
+        }
+        
+        // Score panel
+        float scorePanelY = nextPanelY - 110;
+        float scorePanelHeight = 70;
+        
+        drawRect(panelX, scorePanelY, panelWidth, 3, panelBorder); // Top
+        drawRect(panelX, scorePanelY + scorePanelHeight - 3, panelWidth, 3, panelBorder); // Bottom
+        drawRect(panelX, scorePanelY, 3, scorePanelHeight, panelBorder); // Left
+        drawRect(panelX + panelWidth - 3, scorePanelY, 3, scorePanelHeight, panelBorder); // Right
+        
+        drawText("SCORE", panelX + 10, scorePanelY + scorePanelHeight - 28, 18, textColor);
+        drawNumber(state.score, panelX + 20, scorePanelY + 12, 22, numberColor);
+        
+        // Lines panel
+        float linesPanelY = scorePanelY - 90;
+        float linesPanelHeight = 70;
+        
+        drawRect(panelX, linesPanelY, panelWidth, 3, panelBorder); // Top
+        drawRect(panelX, linesPanelY + linesPanelHeight - 3, panelWidth, 3, panelBorder); // Bottom
+        drawRect(panelX, linesPanelY, 3, linesPanelHeight, panelBorder); // Left
+        drawRect(panelX + panelWidth - 3, linesPanelY, 3, linesPanelHeight, panelBorder); // Right
+        
+        drawText("LINES", panelX + 10, linesPanelY + linesPanelHeight - 28, 18, textColor);
+        drawNumber(state.lines, panelX + 20, linesPanelY + 12, 22, numberColor);
+        
+        // Finesse panel: inputs wasted compared to the shortest way to each placement
+        float finessePanelY = linesPanelY - 90;
+        float finessePanelHeight = 70;
+        
+        drawRect(panelX, finessePanelY, panelWidth, 3, panelBorder); // Top
+        drawRect(panelX, finessePanelY + finessePanelHeight - 3, panelWidth, 3, panelBorder); // Bottom
+        drawRect(panelX, finessePanelY, 3, finessePanelHeight, panelBorder); // Left
+        drawRect(panelX + panelWidth - 3, finessePanelY, 3, finessePanelHeight, panelBorder); // Right
+        
+        drawText("FINESSE", panelX + 10, finessePanelY + finessePanelHeight - 28, 18, textColor);
+        drawNumber(state.finesseErrors, panelX + 20, finessePanelY + 12, 22, numberColor);
+    }
+
+    // Show start screen if game hasn't started
+    {
+        TRACE_ZONE("draw overlays");
+        if (!state.gameStarted) {
+            Color overlayColor(0.0f, 0.0f, 0.0f, 0.8f);
+            drawRect(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT, overlayColor);
+
+            Color titleColor(1.0f, 1.0f, 1.0f, 1.0f);
+            drawText("TETRIS", WINDOW_WIDTH / 2 - 100, WINDOW_HEIGHT / 2 + 50, 40, titleColor);
+
+            Color startColor(1.0f, 1.0f, 0.0f, 1.0f);
+            drawText("PRESS SPACE TO START", WINDOW_WIDTH / 2 - 150, WINDOW_HEIGHT / 2 - 25, 18, startColor);
+        }
+
+        // Show pause indicator if game is paused
+        if (state.paused && state.gameStarted) {
+            Color overlayColor(0.0f, 0.0f, 0.0f, 0.7f);
+            drawRect(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT, overlayColor);
+
+            Color pauseColor(1.0f, 1.0f, 0.0f, 1.0f);
+            drawText("PAUSED", WINDOW_WIDTH / 2 - 70, WINDOW_HEIGHT / 2 + 20, 25, pauseColor);
+
+            Color resumeColor(0.9f, 0.9f, 0.9f, 1.0f);
+            drawText("PRESS SPACE TO RESUME", WINDOW_WIDTH / 2 - 160, WINDOW_HEIGHT / 2 - 30, 18, resumeColor);
+        }
+    
+        // Show game over screen
+        if (state.gameOver) {
+            Color overlayColor(0.0f, 0.0f, 0.0f, 0.8f);
+            drawRect(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT, overlayColor);
+    
+            Color gameOverColor(1.0f, 0.0f, 0.0f, 1.0f);
+            drawText("GAME OVER", WINDOW_WIDTH / 2 - 90, WINDOW_HEIGHT / 2 + 50, 25, gameOverColor);
+    
+            Color scoreColor(1.0f, 1.0f, 1.0f, 1.0f);
+            drawText("SCORE:", WINDOW_WIDTH / 2 - 75, WINDOW_HEIGHT / 2, 20, scoreColor);
+            drawNumber(state.score, WINDOW_WIDTH / 2 + 20, WINDOW_HEIGHT / 2, 20, scoreColor);
+    
+            drawText("LINES CLEARED:", WINDOW_WIDTH / 2 - 125, WINDOW_HEIGHT / 2 - 50, 20, scoreColor);
+            drawNumber(state.lines, WINDOW_WIDTH / 2 + 115, WINDOW_HEIGHT / 2 - 50, 20, scoreColor);
+        
+            Color restartColor(1.0f, 1.0f, 0.0f, 1.0f);
+            drawText("PRESS R TO RESTART", WINDOW_WIDTH / 2 - 140, WINDOW_HEIGHT / 2 - 100, 18, restartColor);
+        }
+    }
+}
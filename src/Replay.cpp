@@ -0,0 +1,132 @@
+#include "headers/Replay.h"
+#include "headers/ByteStream.h"
+#include <algorithm>
+#include <chrono>
+
+void Replay::serialize(std::string& out) const {
+    ByteWriter writer(out);
+    writer.bytes("TRPL", 4);
+    writer.u8(REPLAY_VERSION);
+    writer.u64(seed);
+    writer.u64(dateMs);
+    writer.u64(startTick);
+    writer.u32(ticks);
+    writer.i32(score);
+    writer.i32(lines);
+    writer.str(player);
+    
+    // Events as tick deltas, most are a few ticks apart
+    writer.u32(events.size());
+    uint32_t previousTick = 0;
+    for (const ReplayEvent& event : events) {
+        writer.varint(event.tick - previousTick);
+        writer.u8((uint8_t)event.action);
+        previousTick = event.tick;
+    }
+    
+    writer.u32(keyframes.size());
+    for (const ReplayKeyframe& keyframe : keyframes) {
+        writer.u32(keyframe.tick);
+        writer.u32(keyframe.eventIndex);
+        writer.u32(keyframe.state.size());
+        writer.bytes(keyframe.state.data(), keyframe.state.size());
+    }
+}
+
+bool Replay::deserialize(const void* data, size_t size) {
+    ByteReader reader(data, size);
+    char magic[4];
+    if (!reader.bytes(magic, 4) || std::string(magic, 4) != "TRPL" || reader.u8() != REPLAY_VERSION) {
+        return false;
+    }
+    seed = reader.u64();
+    dateMs = reader.u64();
+    startTick = reader.u64();
+    ticks = reader.u32();
+    score = reader.i32();
+    lines = reader.i32();
+    player = reader.str();
+    
+    uint32_t eventCount = reader.u32();
+    if (eventCount > reader.remaining() / 2) return false; // Each event takes at least 2 bytes
+    events.resize(eventCount);
+    uint32_t tick = 0;
+    for (ReplayEvent& event : events) {
+        tick += reader.varint();
+        event.tick = tick;
+        event.action = (GameAction)reader.u8();
+    }
+    
+    uint32_t keyframeCount = reader.u32();
+    if (keyframeCount > reader.remaining() / 12) return false;
+    keyframes.resize(keyframeCount);
+    for (ReplayKeyframe& keyframe : keyframes) {
+        keyframe.tick = reader.u32();
+        keyframe.eventIndex = reader.u32();
+        uint32_t stateSize = reader.u32();
+        if (!reader.good() || reader.remaining() < stateSize) return false;
+        keyframe.state.assign((const char*)reader.current(), stateSize);
+        reader.skip(stateSize);
+    }
+    return reader.good();
+}
+
+bool Replay::seek(uint32_t tick, TetrisGame& game) const {
+    // Nearest keyframe at or before the target tick
+    auto it = std::upper_bound(keyframes.begin(), keyframes.end(), tick,
+                               [](uint32_t t, const ReplayKeyframe& keyframe) { return t < keyframe.tick; });
+    if (it == keyframes.begin()) return false;
+    const ReplayKeyframe& keyframe = *(it - 1);
+    if (!game.loadState(keyframe.state)) return false;
+    
+    // Re-simulate exactly like the simulation loop: inputs first, then gravity
+    size_t next = keyframe.eventIndex;
+    for (uint32_t t = keyframe.tick; t < tick; t++) {
+        while (next < events.size() && events[next].tick == t) {
+            game.apply(events[next++].action);
+        }
+        game.update((double)(startTick + t) / SIM_TICKS_PER_SECOND);
+    }
+    return true;
+}
+
+void ReplayRecorder::begin(uint64_t tick, const TetrisGame& game, const std::string& player) {
+    replay = Replay();
+    replay.player = player;
+    replay.seed = game.getSeed();
+    replay.dateMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    replay.startTick = tick;
+    
+    ReplayKeyframe keyframe;
+    keyframe.tick = 0;
+    keyframe.eventIndex = 0;
+    game.saveState(keyframe.state);
+    replay.keyframes.push_back(keyframe);
+    recording = true;
+}
+
+void ReplayRecorder::beginTick(uint64_t tick, const TetrisGame& game) {
+    if (!recording) return;
+    uint32_t relative = (uint32_t)(tick - replay.startTick);
+    if (relative > 0 && relative % REPLAY_KEYFRAME_INTERVAL == 0) {
+        ReplayKeyframe keyframe;
+        keyframe.tick = relative;
+        keyframe.eventIndex = replay.events.size();
+        game.saveState(keyframe.state);
+        replay.keyframes.push_back(keyframe);
+    }
+}
+
+void ReplayRecorder::record(uint64_t tick, GameAction action) {
+    if (!recording) return;
+    replay.events.push_back(ReplayEvent{(uint32_t)(tick - replay.startTick), action});
+}
+
+const Replay& ReplayRecorder::finish(uint64_t tick, const TetrisGame& game) {
+    replay.ticks = (uint32_t)(tick - replay.startTick) + 1;
+    replay.score = game.getScore();
+    replay.lines = game.getLines();
+    recording = false;
+    return replay;
+}
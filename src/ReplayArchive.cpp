@@ -0,0 +1,121 @@
+#include "headers/ReplayArchive.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+static const size_t INDEX_HEADER_SIZE = 64;
+
+// 64-bit file position, the data file outgrows a 32-bit long
+static int64_t endOffset(std::FILE* file) {
+#ifdef _WIN32
+    _fseeki64(file, 0, SEEK_END);
+    return _ftelli64(file);
+#else
+    fseeko(file, 0, SEEK_END);
+    return ftello(file);
+#endif
+}
+
+ReplayArchive::ReplayArchive(const std::string& basePath) : dataPath(basePath + ".tra"), indexPath(basePath + ".tri"), count(0) {
+}
+
+bool ReplayArchive::mapIndex() {
+    count = 0;
+    data.close();
+    if (!index.open(indexPath) || index.getSize() < INDEX_HEADER_SIZE) return false;
+    
+    const uint8_t* header = index.getData();
+    uint32_t version;
+    uint64_t entries;
+    std::memcpy(&version, header + 4, sizeof(version));
+    std::memcpy(&entries, header + 8, sizeof(entries));
+    if (std::memcmp(header, "TRIX", 4) != 0 || version != REPLAY_ARCHIVE_VERSION) {
+        index.close();
+        return false;
+    }
+    
+    // An entry written without its count update (interrupted append) is ignored
+    size_t available = (index.getSize() - INDEX_HEADER_SIZE) / sizeof(ReplayIndexEntry);
+    count = entries < available ? (size_t)entries : available;
+    return true;
+}
+
+bool ReplayArchive::open() {
+    return mapIndex();
+}
+
+const ReplayIndexEntry& ReplayArchive::entry(size_t i) const {
+    return ((const ReplayIndexEntry*)(index.getData() + INDEX_HEADER_SIZE))[i];
+}
+
+bool ReplayArchive::extract(size_t i, std::string& blob) {
+    if (i >= count) return false;
+    if (!data.isOpen() && !data.open(dataPath)) return false;
+    
+    const ReplayIndexEntry& e = entry(i);
+    if (e.offset + e.length > data.getSize()) return false;
+    blob.assign((const char*)data.getData() + e.offset, e.length);
+    return true;
+}
+
+bool ReplayArchive::load(size_t i, Replay& replay) {
+    if (i >= count) return false;
+    if (!data.isOpen() && !data.open(dataPath)) return false;
+    
+    const ReplayIndexEntry& e = entry(i);
+    if (e.offset + e.length > data.getSize()) return false;
+    return replay.deserialize(data.getData() + e.offset, e.length);
+}
+
+bool ReplayArchive::append(const Replay& replay) {
+    std::string blob;
+    replay.serialize(blob);
+    
+    // Unmap first, Windows cannot extend a file that is mapped
+    index.close();
+    data.close();
+    
+    std::FILE* dataFile = std::fopen(dataPath.c_str(), "ab");
+    if (!dataFile) return false;
+    int64_t offset = endOffset(dataFile);
+    bool written = std::fwrite(blob.data(), 1, blob.size(), dataFile) == blob.size();
+    written = std::fclose(dataFile) == 0 && written;
+    if (!written || offset < 0) return false;
+    
+    std::FILE* indexFile = std::fopen(indexPath.c_str(), "r+b");
+    uint64_t entries = 0;
+    if (indexFile) {
+        std::fseek(indexFile, 8, SEEK_SET);
+        if (std::fread(&entries, sizeof(entries), 1, indexFile) != 1) entries = 0;
+    } else {
+        indexFile = std::fopen(indexPath.c_str(), "w+b");
+        if (!indexFile) return false;
+        uint8_t header[INDEX_HEADER_SIZE] = {'T', 'R', 'I', 'X'};
+        uint32_t version = REPLAY_ARCHIVE_VERSION;
+        std::memcpy(header + 4, &version, sizeof(version));
+        std::fwrite(header, 1, sizeof(header), indexFile);
+    }
+    
+    ReplayIndexEntry e;
+    std::memset(&e, 0, sizeof(e));
+    e.offset = (uint64_t)offset;
+    e.length = blob.size();
+    e.dateMs = replay.dateMs;
+    e.score = replay.score;
+    e.lines = replay.lines;
+    e.ticks = replay.ticks;
+    std::memset(e.player, 0, sizeof(e.player));
+    std::memcpy(e.player, replay.player.data(), std::min(replay.player.size(), sizeof(e.player)));
+    
+    // Entry first, count last, so a crash never exposes a half-written entry
+    std::fseek(indexFile, (long)(INDEX_HEADER_SIZE + entries * sizeof(ReplayIndexEntry)), SEEK_SET);
+    written = std::fwrite(&e, sizeof(e), 1, indexFile) == 1;
+    std::fflush(indexFile);
+    entries++;
+    std::fseek(indexFile, 8, SEEK_SET);
+    written = std::fwrite(&entries, sizeof(entries), 1, indexFile) == 1 && written;
+    written = std::fclose(indexFile) == 0 && written;
+    
+    mapIndex();
+    return written;
+}
@@ -0,0 +1,482 @@
+#include "headers/Spectator.h"
+#include "headers/Trace.h"
+#include <algorithm>
+#include <chrono>
+
+#ifdef __linux__
+#include <cerrno>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+// Frame header: size placeholder, kind, tick. Returns where the size goes.
+static size_t beginFrame(std::string& out, char kind, uint64_t tick) {
+    size_t start = out.size();
+    ByteWriter writer(out);
+    writer.u32(0);
+    writer.u8((uint8_t)kind);
+    writer.u64(tick);
+    return start;
+}
+
+static void endFrame(std::string& out, size_t start) {
+    uint32_t size = (uint32_t)(out.size() - start - 4);
+    for (int i = 0; i < 4; i++) {
+        out[start + i] = (char)(size >> (8 * i));
+    }
+}
+
+static void writeState(ByteWriter& writer, const SpectatorPieceState& state, uint8_t fields) {
+    writer.u8(fields);
+    if (fields & STATE_PIECE) {
+        writer.u8((uint8_t)state.color);
+        writer.i32(state.x);
+        writer.i32(state.y);
+        writer.u16(state.mask);
+    }
+    if (fields & STATE_NEXT) writer.u8((uint8_t)state.nextType);
+    if (fields & STATE_SCORE) {
+        writer.i32(state.score);
+        writer.i32(state.lines);
+    }
+    if (fields & STATE_FLAGS) writer.u8(state.flags);
+}
+
+void SpectatorView::readState(ByteReader& reader) {
+    uint8_t fields = reader.u8();
+    if (fields & STATE_PIECE) {
+        state.color = reader.u8();
+        state.x = reader.i32();
+        state.y = reader.i32();
+        state.mask = reader.u16();
+    }
+    if (fields & STATE_NEXT) state.nextType = reader.u8();
+    if (fields & STATE_SCORE) {
+        state.score = reader.i32();
+        state.lines = reader.i32();
+    }
+    if (fields & STATE_FLAGS) state.flags = reader.u8();
+}
+
+bool SpectatorView::applyFrame(const uint8_t* frame, size_t size) {
+    ByteReader reader(frame, size);
+    uint8_t kind = reader.u8();
+    uint64_t frameTick = reader.u64();
+    if (kind == 'K') {
+        int newWidth = reader.u16();
+        int newHeight = reader.u32();
+        int first = reader.u32();
+        if (newWidth < 1 || newWidth > MAX_BOARD_WIDTH || newHeight < 1 || newHeight > MAX_BOARD_HEIGHT ||
+            first > newHeight || reader.remaining() < (size_t)(newHeight - first) * newWidth) {
+            return false;
+        }
+        width = newWidth;
+        height = newHeight;
+        top = first;
+        cells.assign((size_t)width * height, 0);
+        reader.bytes(cells.data() + (size_t)top * width, (size_t)(height - top) * width);
+    } else if (kind == 'D') {
+        if (width == 0) return false; // Deltas only make sense after a keyframe
+        for (;;) {
+            DeltaOp op = (DeltaOp)reader.u8();
+            if (!reader.good()) return false;
+            if (op == DeltaOp::End) break;
+            
+            if (op == DeltaOp::Lock) {
+                int color = reader.u8();
+                int x = reader.i32();
+                int y = reader.i32();
+                uint16_t mask = reader.u16();
+                for (int i = 0; i < 4; i++) {
+                    for (int j = 0; j < 4; j++) {
+                        int cellX = x + j;
+                        int cellY = y + i;
+                        if ((mask & (1 << (i * 4 + j))) && cellX >= 0 && cellX < width && cellY >= 0 && cellY < height) {
+                            cells[(size_t)cellY * width + cellX] = (unsigned char)color;
+                            top = std::min(top, cellY);
+                        }
+                    }
+                }
+            } else if (op == DeltaOp::Clear) {
+                int count = reader.u8();
+                for (int i = 0; i < count; i++) {
+                    int row = reader.u32();
+                    if (row >= height) return false;
+                    if (row < top) continue;
+                    // Only the rows between the stack top and the cleared row move
+                    unsigned char* base = &cells[(size_t)top * width];
+                    std::memmove(base + width, base, (size_t)(row - top) * width);
+                    std::fill(base, base + width, 0);
+                    top++;
+                }
+            } else {
+                return false;
+            }
+        }
+    } else {
+        return false;
+    }
+    readState(reader);
+    tick = frameTick;
+    return reader.good();
+}
+
+void SpectatorView::encodeKeyframe(std::string& out) const {
+    size_t start = beginFrame(out, 'K', tick);
+    ByteWriter writer(out);
+    writer.u16((uint16_t)width);
+    writer.u32(height);
+    writer.u32(top);
+    writer.bytes(cells.data() + (size_t)top * width, (size_t)(height - top) * width);
+    writeState(writer, state, STATE_ALL);
+    endFrame(out, start);
+}
+
+void SpectatorEncoder::encode(uint64_t tick, const TetrisGame& game, GameDelta& delta, std::string& out) {
+    const TetrisPiece& piece = game.getCurrentPiece();
+    SpectatorPieceState current;
+    current.color = piece.type + 1;
+    current.x = piece.x;
+    current.y = piece.y;
+    current.mask = shapeMask(piece.shape);
+    current.nextType = game.getNextType();
+    current.score = game.getScore();
+    current.lines = game.getLines();
+    current.flags = (game.isGameOver() ? 1 : 0) | (game.isPaused() ? 2 : 0) | (game.hasStarted() ? 4 : 0);
+    
+    bool keyframe = needKeyframe || delta.reset;
+    size_t start = beginFrame(out, keyframe ? 'K' : 'D', tick);
+    ByteWriter writer(out);
+    uint8_t fields = STATE_ALL;
+    if (keyframe) {
+        // Only the rows from the top of the stack down hold cells
+        int width = game.getBoardWidth();
+        int height = game.getBoardHeight();
+        int first = game.getStackTop();
+        writer.u16((uint16_t)width);
+        writer.u32(height);
+        writer.u32(first);
+        for (int y = first; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                writer.u8((uint8_t)game.getCell(x, y));
+            }
+        }
+    } else {
+        writer.bytes(delta.ops.data(), delta.ops.size());
+        writer.u8((uint8_t)DeltaOp::End);
+        fields = 0;
+        if (current.color != sent.color || current.x != sent.x || current.y != sent.y || current.mask != sent.mask) {
+            fields |= STATE_PIECE;
+        }
+        if (current.nextType != sent.nextType) fields |= STATE_NEXT;
+        if (current.score != sent.score || current.lines != sent.lines) fields |= STATE_SCORE;
+        if (current.flags != sent.flags) fields |= STATE_FLAGS;
+    }
+    writeState(writer, current, fields);
+    endFrame(out, start);
+    
+    sent = current;
+    needKeyframe = false;
+    delta.clearAll();
+}
+
+SpectatorServer::SpectatorServer() : clientCount(0), listenFd(-1), epollFd(-1), running(false) {
+}
+
+SpectatorServer::~SpectatorServer() {
+    stop();
+}
+
+void SpectatorServer::publish(uint64_t tick, const TetrisGame& game) {
+    if (!running.load(std::memory_order_relaxed)) return;
+    
+    // Reuse a buffer the server is done with, so steady-state publishing doesn't allocate
+    std::string* frame;
+    if (recycled.pop(frame)) {
+        frame->clear();
+    } else {
+        frame = new std::string();
+    }
+    encoder.encode(tick, game, delta, *frame);
+    if (!frames.push(frame)) {
+        delete frame;
+        encoder.requestKeyframe(); // The server missed this change, resync it with the next frame
+    }
+}
+
+const std::shared_ptr<const std::string>& SpectatorServer::currentKeyframe() {
+    if (!keyframe) {
+        auto encoded = std::make_shared<std::string>();
+        mirror.encodeKeyframe(*encoded);
+        keyframe = std::move(encoded);
+    }
+    return keyframe;
+}
+
+#ifdef __linux__
+
+bool SpectatorServer::start(int port) {
+    stop();
+    
+    // Every spectator is a descriptor, allow as many as the hard limit permits
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+    
+    listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) return false;
+    
+    int one = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = listenFd;
+    if (bind(listenFd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listenFd, SOMAXCONN) != 0 ||
+        epollFd < 0 || epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event) != 0) {
+        stop();
+        return false;
+    }
+    
+    encoder.requestKeyframe();
+    running = true;
+    thread = std::thread(&SpectatorServer::serverLoop, this);
+    return true;
+}
+
+void SpectatorServer::stop() {
+    if (running) {
+        running = false;
+        thread.join(); // The loop wakes at least every flush interval
+    }
+    for (Client* client : clients) {
+        if (client) closeClient(client);
+    }
+    clients.clear();
+    if (epollFd >= 0) close(epollFd);
+    if (listenFd >= 0) close(listenFd);
+    epollFd = listenFd = -1;
+    
+    std::string* frame;
+    while (frames.pop(frame)) delete frame;
+    while (recycled.pop(frame)) delete frame;
+    keyframe.reset();
+}
+
+void SpectatorServer::serverLoop() {
+    using Clock = std::chrono::steady_clock;
+    const auto flushInterval = std::chrono::milliseconds(1000 / SPECTATOR_FLUSH_HZ);
+    std::vector<epoll_event> events(1024);
+    Trace::setThreadName("spectators");
+    auto nextFlush = Clock::now();
+    while (running.load(std::memory_order_relaxed)) {
+        int timeout = (int)std::chrono::duration_cast<std::chrono::milliseconds>(nextFlush - Clock::now()).count();
+        int count = epoll_wait(epollFd, events.data(), (int)events.size(), std::max(0, timeout));
+        for (int i = 0; i < count; i++) {
+            int fd = events[i].data.fd;
+            if (fd == listenFd) {
+                acceptClients();
+                continue;
+            }
+            Client* client = (size_t)fd < clients.size() ? clients[fd] : nullptr;
+            if (!client) continue;
+            if (events[i].events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) {
+                closeClient(client);
+                continue;
+            }
+            if (events[i].events & EPOLLIN) {
+                readClient(client);
+                if (!clients[fd]) continue;
+            }
+            if (events[i].events & EPOLLOUT) {
+                client->writable = true;
+                flushClient(client);
+            }
+        }
+        
+        auto current = Clock::now();
+        if (current < nextFlush) continue;
+        nextFlush = current + flushInterval;
+        
+        // Everything published since the last flush goes out as one shared buffer
+        std::string* frame;
+        std::string batch;
+        while (frames.pop(frame)) {
+            mirror.applyFrame((const uint8_t*)frame->data() + 4, frame->size() - 4);
+            batch += *frame;
+            if (!recycled.push(frame)) delete frame;
+        }
+        if (batch.empty()) continue;
+        TRACE_ZONE("spectator fan-out");
+        keyframe.reset();
+        
+        std::shared_ptr<const std::string> shared = std::make_shared<const std::string>(std::move(batch));
+        for (Client* client : clients) {
+            if (!client) continue;
+            if (!client->synced) {
+                // Joined before the first keyframe, start from the current state
+                client->synced = true;
+                if (!enqueue(client, currentKeyframe())) continue;
+            } else if (!enqueue(client, shared)) {
+                continue;
+            }
+            flushClient(client);
+        }
+    }
+}
+
+void SpectatorServer::acceptClients() {
+    for (;;) {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return; // EAGAIN once the backlog is empty
+        
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        epoll_event event = {};
+        event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET; // Edge triggered, EPOLLOUT fires only when the socket drains
+        event.data.fd = fd;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            close(fd);
+            continue;
+        }
+        
+        if ((size_t)fd >= clients.size()) clients.resize(fd + 1, nullptr);
+        Client* client = new Client{fd, {}, 0, 0, true, 0, false};
+        clients[fd] = client;
+        clientCount++;
+        if (mirror.width > 0) {
+            client->synced = true;
+            if (enqueue(client, currentKeyframe())) flushClient(client);
+        }
+    }
+}
+
+void SpectatorServer::closeClient(Client* client) {
+    close(client->fd); // Also removes it from the epoll set
+    clients[client->fd] = nullptr;
+    clientCount--;
+    delete client;
+}
+
+void SpectatorServer::readClient(Client* client) {
+    // Spectators have nothing to say, just notice when they hang up
+    char discard[256];
+    for (;;) {
+        ssize_t received = recv(client->fd, discard, sizeof(discard), 0);
+        if (received > 0) continue;
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        if (received < 0 && errno == EINTR) continue;
+        closeClient(client);
+        return;
+    }
+}
+
+// Returns false if the client was dropped
+bool SpectatorServer::enqueue(Client* client, const std::shared_ptr<const std::string>& data) {
+    size_t limit = SPECTATOR_MAX_QUEUED_BYTES + (size_t)(mirror.height - mirror.top) * mirror.width;
+    if (client->queued + data->size() > limit) {
+        // Too slow to keep up: drop the backlog (finishing a partly sent buffer) and restart it from a keyframe
+        if (++client->resyncs > SPECTATOR_MAX_RESYNCS) {
+            closeClient(client);
+            return false;
+        }
+        size_t keep = client->offset > 0 ? 1 : 0;
+        while (client->queue.size() > keep) {
+            client->queued -= client->queue.back()->size();
+            client->queue.pop_back();
+        }
+        const std::shared_ptr<const std::string>& resync = currentKeyframe();
+        client->queue.push_back(resync);
+        client->queued += resync->size();
+        return true;
+    }
+    client->queue.push_back(data);
+    client->queued += data->size();
+    return true;
+}
+
+void SpectatorServer::flushClient(Client* client) {
+    while (client->writable && !client->queue.empty()) {
+        iovec parts[64];
+        int count = 0;
+        for (auto it = client->queue.begin(); it != client->queue.end() && count < 64; ++it, ++count) {
+            size_t skip = count == 0 ? client->offset : 0;
+            parts[count].iov_base = (void*)((*it)->data() + skip);
+            parts[count].iov_len = (*it)->size() - skip;
+        }
+        msghdr message = {};
+        message.msg_iov = parts;
+        message.msg_iovlen = count;
+        ssize_t sent = sendmsg(client->fd, &message, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                client->writable = false; // Resumed by the next EPOLLOUT edge
+            } else if (errno != EINTR) {
+                closeClient(client);
+                return;
+            }
+            continue;
+        }
+        
+        // Release the buffers that went out completely
+        client->queued -= sent;
+        size_t left = (size_t)sent;
+        while (left > 0) {
+            size_t pending = client->queue.front()->size() - client->offset;
+            if (left < pending) {
+                client->offset += left;
+                break;
+            }
+            left -= pending;
+            client->queue.pop_front();
+            client->offset = 0;
+        }
+    }
+    if (client->queue.empty()) client->resyncs = 0;
+}
+
+#else
+
+bool SpectatorServer::start(int port) {
+    (void)port;
+    return false; // No epoll on this platform
+}
+
+void SpectatorServer::stop() {
+}
+
+void SpectatorServer::serverLoop() {
+}
+
+void SpectatorServer::acceptClients() {
+}
+
+void SpectatorServer::closeClient(Client* client) {
+    (void)client;
+}
+
+void SpectatorServer::readClient(Client* client) {
+    (void)client;
+}
+
+void SpectatorServer::flushClient(Client* client) {
+    (void)client;
+}
+
+bool SpectatorServer::enqueue(Client* client, const std::shared_ptr<const std::string>& data) {
+    (void)client;
+    (void)data;
+    return false;
+}
+
+#endif
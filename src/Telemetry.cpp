@@ -0,0 +1,105 @@
+#include "headers/Telemetry.h"
+
+const TelemetryEventInfo TELEMETRY_EVENTS[] = {
+    {"game_start",    0, {}},
+    {"piece_spawned", 1, {"piece"}},
+    {"piece_locked",  3, {"piece", "x", "y"}},
+    {"lines_cleared", 3, {"count", "total", "score"}},
+    {"level_change",  1, {"fall_ms"}},
+    {"pause",         0, {}},
+    {"resume",        0, {}},
+    {"game_over",     2, {"score", "lines"}},
+    {"tick_duration", 1, {"ns"}},
+    {"dropped",       1, {"count"}}
+};
+
+Telemetry::Telemetry(const std::string& path) : file(std::fopen(path.c_str(), "wb")),
+                                                start(std::chrono::steady_clock::now()), lastTime(0),
+                                                dropped(0), running(true) {
+    if (!file) return;
+    
+    uint64_t epochMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    uint8_t header[13] = {'T', 'T', 'E', 'L', TELEMETRY_VERSION};
+    for (int i = 0; i < 8; i++) {
+        header[5 + i] = (epochMs >> (8 * i)) & 0xFF;
+    }
+    std::fwrite(header, 1, sizeof(header), file);
+    
+    buffer.reserve(64 * 1024);
+    flusher = std::thread(&Telemetry::flushLoop, this);
+}
+
+Telemetry::~Telemetry() {
+    if (!file) return;
+    
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        running = false;
+    }
+    wake.notify_one();
+    flusher.join();
+    
+    // Final drain after the flusher stopped, then record how many events were lost
+    drain();
+    uint64_t lost = dropped.load();
+    if (lost > 0) {
+        Record record{lastTime * 1000, TelemetryEvent::Dropped, {(int32_t)lost, 0, 0}};
+        buffer.clear(); // drain() already wrote what it held
+        writeRecord(record);
+        std::fwrite(buffer.data(), 1, buffer.size(), file);
+    }
+    std::fclose(file);
+}
+
+void Telemetry::emit(TelemetryEvent event, int32_t a, int32_t b, int32_t c) {
+    if (!file) return;
+    uint64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    if (!ring.push(Record{now, event, {a, b, c}})) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void Telemetry::flushLoop() {
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    while (running) {
+        wake.wait_for(lock, std::chrono::milliseconds(100));
+        lock.unlock();
+        drain();
+        lock.lock();
+    }
+}
+
+void Telemetry::drain() {
+    buffer.clear();
+    Record record;
+    while (ring.pop(record)) {
+        writeRecord(record);
+    }
+    if (!buffer.empty()) {
+        std::fwrite(buffer.data(), 1, buffer.size(), file);
+        std::fflush(file);
+    }
+}
+
+void Telemetry::writeVarint(uint64_t value) {
+    while (value >= 0x80) {
+        buffer.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back((uint8_t)value);
+}
+
+void Telemetry::writeRecord(const Record& record) {
+    buffer.push_back((uint8_t)record.event);
+    uint64_t time = record.time / 1000;
+    writeVarint(time > lastTime ? time - lastTime : 0);
+    if (time > lastTime) lastTime = time;
+    
+    int argCount = TELEMETRY_EVENTS[(int)record.event].argCount;
+    for (int i = 0; i < argCount; i++) {
+        int32_t arg = record.args[i];
+        writeVarint(((uint32_t)arg << 1) ^ (uint32_t)(arg >> 31)); // Zigzag
+    }
+}
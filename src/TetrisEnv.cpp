@@ -0,0 +1,78 @@
+#include "headers/TetrisEnv.h"
+#include "headers/LockstepEngine.h"
+
+static_assert((int)LOCKSTEP_LEFT == TETRIS_ACTION_LEFT && (int)LOCKSTEP_RIGHT == TETRIS_ACTION_RIGHT &&
+              (int)LOCKSTEP_ROTATE == TETRIS_ACTION_ROTATE && (int)LOCKSTEP_SOFT_DROP == TETRIS_ACTION_SOFT_DROP &&
+              (int)LOCKSTEP_HARD_DROP == TETRIS_ACTION_HARD_DROP, "Actions are passed to the engine unchanged");
+static_assert(TETRIS_ENV_MAX_PREVIEW == PIECE_PREVIEW_MAX, "Preview limits must agree");
+
+// Every environment plays like its own TetrisGame, stepped together by the lockstep engine
+struct TetrisEnv {
+    LockstepEngine engine;
+    
+    TetrisEnv(int32_t numEnvs, uint64_t seed, int32_t ticksPerStep, int previewDepth, Randomizer randomizer)
+        : engine(numEnvs, seed, ticksPerStep, previewDepth, randomizer) {}
+};
+
+static const int PLANE_SIZE = BOARD_WIDTH * BOARD_HEIGHT;
+
+static void writeObservation(const LockstepEngine& engine, int index, const TetrisEnvBuffers* out) {
+    uint8_t* locked = out->board + (size_t)index * TETRIS_ENV_PLANES * PLANE_SIZE;
+    engine.writeBoard(index, locked, locked + PLANE_SIZE);
+    int32_t* pieces = out->pieces + (size_t)index * (1 + engine.getPreviewDepth());
+    pieces[0] = engine.getCurrentType(index);
+    for (int i = 0; i < engine.getPreviewDepth(); i++) {
+        pieces[1 + i] = engine.getPreviewType(index, i);
+    }
+}
+
+TetrisEnv* tetris_env_create(int32_t num_envs, uint64_t seed, int32_t ticks_per_step) {
+    return tetris_env_create_ex(num_envs, seed, ticks_per_step, 1, TETRIS_RANDOMIZER_UNIFORM);
+}
+
+TetrisEnv* tetris_env_create_ex(int32_t num_envs, uint64_t seed, int32_t ticks_per_step, int32_t preview_depth,
+                                int32_t randomizer) {
+    if (num_envs <= 0 || ticks_per_step <= 0 || preview_depth < 1 || preview_depth > TETRIS_ENV_MAX_PREVIEW ||
+        (randomizer != TETRIS_RANDOMIZER_UNIFORM && randomizer != TETRIS_RANDOMIZER_BAG7)) {
+        return nullptr;
+    }
+    Randomizer pieces = randomizer == TETRIS_RANDOMIZER_BAG7 ? Randomizer::Bag7 : Randomizer::Uniform;
+    return new TetrisEnv(num_envs, seed, ticks_per_step, preview_depth, pieces); // Seeds are decorrelated per env
+}
+
+void tetris_env_destroy(TetrisEnv* env) {
+    delete env;
+}
+
+int32_t tetris_env_num_envs(const TetrisEnv* env) {
+    return (int32_t)env->engine.size();
+}
+
+int32_t tetris_env_preview_depth(const TetrisEnv* env) {
+    return env->engine.getPreviewDepth();
+}
+
+int32_t tetris_env_board_width(void) {
+    return BOARD_WIDTH;
+}
+
+int32_t tetris_env_board_height(void) {
+    return BOARD_HEIGHT;
+}
+
+void tetris_env_reset(TetrisEnv* env, const TetrisEnvBuffers* out) {
+    env->engine.restartAll();
+    for (int i = 0; i < env->engine.size(); i++) {
+        writeObservation(env->engine, i, out);
+        out->rewards[i] = 0.0f;
+        out->dones[i] = 0;
+    }
+}
+
+void tetris_env_step(TetrisEnv* env, const int32_t* actions, const TetrisEnvBuffers* out) {
+    // Finished games come back restarted, the observations below are the new games' first states
+    env->engine.step(actions, out->rewards, out->dones);
+    for (int i = 0; i < env->engine.size(); i++) {
+        writeObservation(env->engine, i, out);
+    }
+}
@@ -1,42 +1,76 @@
 #include "headers/TetrisGame.h"
-#include <GLFW/glfw3.h>
+#include "headers/ByteStream.h"
+#include "headers/Trace.h"
 #include <iostream>
+#include <algorithm>
 
-TetrisGame::TetrisGame() : board(BOARD_HEIGHT, std::vector<int>(BOARD_WIDTH, 0)),
-                          currentPiece(0), nextPiece(0), rng(std::chrono::steady_clock::now().time_since_epoch().count()),
-                          pieceDist(0, 6), lastFall(0), fallSpeed(1.0), score(0), lines(0), 
-                          gameOver(false), paused(false), gameStarted(false) {
-    renderer = new Renderer();
+TetrisGame::TetrisGame() : TetrisGame(std::chrono::steady_clock::now().time_since_epoch().count()) {
+}
+
+TetrisGame::TetrisGame(unsigned long long seed, int width, int height, int previewDepth, Randomizer randomizer) : boardWidth(0), boardHeight(0),
+                          currentPiece(0), seed(seed), queue(seed, previewDepth, randomizer),
+                          lastFall(0), now(0), fallSpeed(1.0), score(0), lines(0), 
+                          gameOver(false), paused(false), gameStarted(false), gravity20G(false), dirty(DIRTY_ALL), pieceInputs(0), finesseErrors(0), finesseTracking(false), telemetry(nullptr), delta(nullptr) {
+    resetBoard(width, height);
     spawnNewPiece();
-    generateNextPiece();
 }
 
 TetrisGame::~TetrisGame() {
-    delete renderer;
+}
+
+void TetrisGame::resetBoard(int width, int height) {
+    boardWidth = std::max(4, std::min(width, MAX_BOARD_WIDTH));
+    boardHeight = std::max(4, std::min(height, MAX_BOARD_HEIGHT));
+    cells.assign((size_t)boardWidth * boardHeight, 0);
+    rowSlot.resize(boardHeight);
+    for (int y = 0; y < boardHeight; y++) {
+        rowSlot[y] = y;
+    }
+    rowFill.assign(boardHeight, 0);
+    columnHeights.assign(boardWidth, 0);
+    columnFill.assign(boardWidth, 0);
+    size_t finesseStates = (size_t)4 * FINESSE_MAX_ROWS * (boardWidth + 3);
+    finesseVisited.resize((finesseStates + 63) / 64);
+    finesseQueue.resize(finesseStates);
+    if (delta) delta->markReset();
+}
+
+int TetrisGame::getStackTop() const {
+    int stackTop = boardHeight;
+    for (int x = 0; x < boardWidth; x++) {
+        stackTop = std::min(stackTop, boardHeight - columnHeights[x]);
+    }
+    return stackTop;
 }
 
 void TetrisGame::spawnNewPiece() {
-    currentPiece = nextPiece;
-    generateNextPiece();
+    currentPiece = TetrisPiece(queue.pop());
+    currentPiece.x = boardWidth / 2 - 2;
+    pieceInputs = 0;
+    dirty |= DIRTY_PIECE;
     if (checkCollision(currentPiece, 0, 0)) {
         gameOver = true;
+        dirty |= DIRTY_OVERLAY;
+        if (telemetry) telemetry->emit(TelemetryEvent::GameOver, score, lines);
+        return;
     }
+    if (gravity20G) {
+        currentPiece.y += dropDistance(currentPiece);
+    }
+    if (telemetry) telemetry->emit(TelemetryEvent::PieceSpawned, currentPiece.type);
 }
 
-void TetrisGame::generateNextPiece() {
-    nextPiece = TetrisPiece(pieceDist(rng));
-}
-
-bool TetrisGame::checkCollision(const TetrisPiece& piece, int dx, int dy) {
+bool TetrisGame::checkCollision(const TetrisPiece& piece, int dx, int dy) const {
+    TRACE_ZONE("checkCollision");
     for (int i = 0; i < 4; i++) {
         for (int j = 0; j < 4; j++) {
             if (piece.shape[i][j] != 0) {
                 int newX = piece.x + j + dx;
                 int newY = piece.y + i + dy;
                 
-                if (newX < 0 || newX >= BOARD_WIDTH || 
-                    newY >= BOARD_HEIGHT || 
-                    (newY >= 0 && board[newY][newX] != 0)) {
+                if (newX < 0 || newX >= boardWidth || 
+                    newY >= boardHeight || 
+                    (newY >= 0 && getCell(newX, newY) != 0)) {
                     return true;
                 }
             }
@@ -45,54 +79,241 @@ bool TetrisGame::checkCollision(const TetrisPiece& piece, int dx, int dy) {
     return false;
 }
 
+bool TetrisGame::checkCollision(const int cells[4][2], int x, int y) const {
+    for (int k = 0; k < 4; k++) {
+        int cellX = x + cells[k][0];
+        int cellY = y + cells[k][1];
+        if (cellX < 0 || cellX >= boardWidth || cellY >= boardHeight || (cellY >= 0 && getCell(cellX, cellY) != 0)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Rows the piece can fall before landing, from the column heights and the piece's bottom profile
+int TetrisGame::dropDistance(const TetrisPiece& piece) const {
+    int distance = boardHeight;
+    for (int j = 0; j < 4; j++) {
+        if (piece.bottom[j] < 0) continue;
+        int surface = boardHeight - columnHeights[piece.x + j]; // Topmost filled row (or floor)
+        int pieceRow = piece.y + piece.bottom[j];
+        if (pieceRow >= surface) {
+            // Piece is tucked under an overhang, heights don't describe the cells below it
+            int steps = 0;
+            while (!checkCollision(piece, 0, steps + 1)) {
+                steps++;
+            }
+            return steps;
+        }
+        distance = std::min(distance, surface - 1 - pieceRow);
+    }
+    return distance;
+}
+
+// Fewest moves and rotations that bring a fresh piece from spawn to where the current
+// piece is about to lock, or -1 if the stack is too high to analyze. Breadth-first over
+// (x, y, rotation); falling is free because gravity does it, so every state reached at
+// a given cost also reaches the states straight below it at that cost.
+int TetrisGame::finesseOptimum() {
+    TRACE_ZONE("finesseOptimum");
+    // Cell offsets of each rotation, plus the normalized mask that identifies a placement
+    struct Rotation {
+        int cells[4][2];
+        uint16_t mask;
+        int minRow, minCol;
+    } rotations[4];
+    TetrisPiece piece(currentPiece.type);
+    for (int r = 0; r < 4; r++) {
+        Rotation& rot = rotations[r];
+        int count = 0;
+        rot.minRow = rot.minCol = 4;
+        for (int i = 0; i < 4; i++) {
+            for (int j = 0; j < 4; j++) {
+                if (piece.shape[i][j] != 0 && count < 4) {
+                    rot.cells[count][0] = j;
+                    rot.cells[count][1] = i;
+                    count++;
+                    rot.minRow = std::min(rot.minRow, i);
+                    rot.minCol = std::min(rot.minCol, j);
+                }
+            }
+        }
+        rot.mask = 0;
+        for (int k = 0; k < count; k++) {
+            rot.mask |= 1 << ((rot.cells[k][1] - rot.minRow) * 4 + rot.cells[k][0] - rot.minCol);
+        }
+        piece.rotate();
+    }
+    
+    // The placement to reach, in the same normalized form
+    uint16_t targetMask = 0;
+    int targetRow = 4, targetCol = 4;
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            if (currentPiece.shape[i][j] != 0) {
+                targetRow = std::min(targetRow, i);
+                targetCol = std::min(targetCol, j);
+            }
+        }
+    }
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            if (currentPiece.shape[i][j] != 0) targetMask |= 1 << ((i - targetRow) * 4 + j - targetCol);
+        }
+    }
+    targetRow += currentPiece.y;
+    targetCol += currentPiece.x;
+    
+    // Above the stack only the walls matter, so the piece can start the search just above it
+    int top = std::max(0, getStackTop() - 4);
+    int rows = boardHeight - top;
+    int columns = boardWidth + 3; // x from -3, pieces sit anywhere in their 4x4 box
+    if (rows > FINESSE_MAX_ROWS) return -1;
+    std::fill(finesseVisited.begin(), finesseVisited.end(), 0);
+    
+    int head = 0, tail = 0;
+    auto reach = [&](int x, int y, int r) {
+        // Mark the state and everything it can fall to
+        for (; !checkCollision(rotations[r].cells, x, y); y++) {
+            int index = (r * rows + (y - top)) * columns + (x + 3);
+            uint64_t bit = 1ULL << (index & 63);
+            if (finesseVisited[index >> 6] & bit) return false;
+            finesseVisited[index >> 6] |= bit;
+            finesseQueue[tail++] = index;
+            const Rotation& rot = rotations[r];
+            if (rot.mask == targetMask && y + rot.minRow == targetRow && x + rot.minCol == targetCol) return true;
+        }
+        return false;
+    };
+    
+    int spawnX = boardWidth / 2 - 2;
+    if (reach(spawnX, top, 0)) return 0;
+    for (int cost = 1; head < tail; cost++) {
+        int levelEnd = tail;
+        for (; head < levelEnd; head++) {
+            int index = finesseQueue[head];
+            int x = index % columns - 3;
+            int y = (index / columns) % rows + top;
+            int r = index / columns / rows;
+            if (reach(x - 1, y, r) || reach(x + 1, y, r) || reach(x, y, (r + 1) & 3)) return cost;
+        }
+    }
+    return -1;
+}
+
 void TetrisGame::placePiece() {
+    TRACE_ZONE("placePiece");
+    if (finesseTracking) {
+        int optimum = finesseOptimum();
+        if (optimum >= 0 && pieceInputs > optimum) {
+            finesseErrors += pieceInputs - optimum;
+            dirty |= DIRTY_SCORE;
+        }
+    }
+    
     for (int i = 0; i < 4; i++) {
         for (int j = 0; j < 4; j++) {
             if (currentPiece.shape[i][j] != 0) {
                 int boardX = currentPiece.x + j;
                 int boardY = currentPiece.y + i;
                 if (boardY >= 0) {
-                    board[boardY][boardX] = currentPiece.shape[i][j];
+                    cells[rowSlot[boardY] * boardWidth + boardX] = currentPiece.shape[i][j];
+                    rowFill[rowSlot[boardY]]++;
+                    columnFill[boardX]++;
+                    columnHeights[boardX] = std::max(columnHeights[boardX], boardHeight - boardY);
                 }
             }
         }
     }
+    dirty |= DIRTY_BOARD;
+    if (delta) delta->lock(currentPiece.type + 1, currentPiece.x, currentPiece.y, currentPiece.shape);
+    if (telemetry) telemetry->emit(TelemetryEvent::PieceLocked, currentPiece.type, currentPiece.x, currentPiece.y);
     clearLines();
     spawnNewPiece();
 }
 
+// Only the rows under the piece that just locked can have become full. Clearing
+// compacts the row indices between the stack top and the lowest cleared row and
+// recycles the cleared rows as empty rows above the stack: O(k * width) plus the
+// stack depth above the cleared rows. Column heights add, for each column whose top
+// cell was cleared, the empty cells down to its next filled one: none for a column
+// the clear leaves empty, but up to the board height when the cleared rows roofed a
+// deep hole.
 void TetrisGame::clearLines() {
+    TRACE_ZONE("clearLines");
+    int fullRows[4];
     int linesCleared = 0;
-    for (int y = BOARD_HEIGHT - 1; y >= 0; y--) {
-        bool fullLine = true;
-        for (int x = 0; x < BOARD_WIDTH; x++) {
-            if (board[y][x] == 0) {
-                fullLine = false;
-                break;
-            }
-        }
-        
-        if (fullLine) {
-            board.erase(board.begin() + y);
-            board.insert(board.begin(), std::vector<int>(BOARD_WIDTH, 0));
-            linesCleared++;
-            y++; // Check the same line again
+    for (int i = 0; i < 4; i++) {
+        int y = currentPiece.y + i;
+        if (y >= 0 && y < boardHeight && rowFill[rowSlot[y]] == boardWidth) {
+            fullRows[linesCleared++] = y;
         }
     }
     
     if (linesCleared > 0) {
+        if (delta) delta->clear(fullRows, linesCleared);
+        
+        int stackTop = getStackTop();
+        
+        // Empty the cleared rows, they are reused above the stack
+        int clearedSlots[4];
+        for (int i = 0; i < linesCleared; i++) {
+            int slot = rowSlot[fullRows[i]];
+            std::fill(cells.begin() + (size_t)slot * boardWidth, cells.begin() + (size_t)(slot + 1) * boardWidth, 0);
+            rowFill[slot] = 0;
+            clearedSlots[i] = slot;
+        }
+        
+        // Shift the surviving rows in [stackTop, lowest cleared row] down
+        int lowest = fullRows[linesCleared - 1];
+        int write = lowest;
+        int next = linesCleared - 1;
+        for (int y = lowest; y >= stackTop; y--) {
+            if (next >= 0 && fullRows[next] == y) {
+                next--;
+                continue;
+            }
+            rowSlot[write--] = rowSlot[y];
+        }
+        for (int i = 0; i < linesCleared; i++) {
+            rowSlot[stackTop + i] = clearedSlots[i];
+        }
+        
+        // Every column had a cell in each cleared row, so its top drops by at least linesCleared.
+        // A column with no cells left is known from its count and skips the scan to the floor.
+        for (int x = 0; x < boardWidth; x++) {
+            columnFill[x] -= linesCleared;
+            int height = columnFill[x] > 0 ? std::max(0, columnHeights[x] - linesCleared) : 0;
+            while (height > 0 && getCell(x, boardHeight - height) == 0) {
+                height--;
+            }
+            columnHeights[x] = height;
+        }
+        
         lines += linesCleared;
         score += linesCleared * linesCleared * 100; // Bonus for multiple lines
+        dirty |= DIRTY_SCORE;
+        double previousSpeed = fallSpeed;
         fallSpeed = std::max(0.1, 1.0 - lines * 0.05); // Increase speed
+        
+        if (telemetry) {
+            telemetry->emit(TelemetryEvent::LinesCleared, linesCleared, lines, score);
+            if (fallSpeed != previousSpeed) {
+                telemetry->emit(TelemetryEvent::LevelChange, (int32_t)(fallSpeed * 1000 + 0.5));
+            }
+        }
     }
 }
 
 void TetrisGame::update(double currentTime) {
+    TRACE_ZONE("update");
+    now = currentTime;
     if (gameOver || paused || !gameStarted) return;
     
     if (currentTime - lastFall > fallSpeed) {
         if (!checkCollision(currentPiece, 0, 1)) {
             currentPiece.y++;
+            dirty |= DIRTY_PIECE;
         } else {
             placePiece();
         }
@@ -100,15 +321,54 @@ void TetrisGame::update(double currentTime) {
     }
 }
 
+void TetrisGame::apply(GameAction action) {
+    switch (action) {
+        case GameAction::MoveLeft:
+            moveLeft();
+            break;
+        case GameAction::MoveRight:
+            moveRight();
+            break;
+        case GameAction::SoftDrop:
+            softDrop();
+            break;
+        case GameAction::Rotate:
+            rotate();
+            break;
+        case GameAction::HardDrop:
+            drop();
+            break;
+        case GameAction::Restart:
+            restart();
+            break;
+        case GameAction::StartOrPause:
+            if (!gameStarted) {
+                startGame();
+            } else {
+                togglePause();
+            }
+            break;
+        case GameAction::ToggleGravity20G:
+            toggleGravity20G();
+            break;
+    }
+}
+
 void TetrisGame::moveLeft() {
     if (!gameOver && !paused && gameStarted && !checkCollision(currentPiece, -1, 0)) {
         currentPiece.x--;
+        pieceInputs++;
+        dirty |= DIRTY_PIECE;
+        if (gravity20G) currentPiece.y += dropDistance(currentPiece);
     }
 }
 
 void TetrisGame::moveRight() {
     if (!gameOver && !paused && gameStarted && !checkCollision(currentPiece, 1, 0)) {
         currentPiece.x++;
+        pieceInputs++;
+        dirty |= DIRTY_PIECE;
+        if (gravity20G) currentPiece.y += dropDistance(currentPiece);
     }
 }
 
@@ -118,15 +378,16 @@ void TetrisGame::rotate() {
         testPiece.rotate();
         if (!checkCollision(testPiece, 0, 0)) {
             currentPiece.rotate();
+            pieceInputs++;
+            dirty |= DIRTY_PIECE;
+            if (gravity20G) currentPiece.y += dropDistance(currentPiece);
         }
     }
 }
 
 void TetrisGame::drop() {
     if (!gameOver && !paused && gameStarted) {
-        while (!checkCollision(currentPiece, 0, 1)) {
-            currentPiece.y++;
-        }
+        currentPiece.y += dropDistance(currentPiece);
         placePiece();
     }
 }
@@ -135,181 +396,184 @@ void TetrisGame::softDrop() {
     if (!gameOver && !paused && gameStarted && !checkCollision(currentPiece, 0, 1)) {
         currentPiece.y++;
         score += 1; // Small bonus for soft drop
+        dirty |= DIRTY_PIECE | DIRTY_SCORE;
     }
 }
 
 void TetrisGame::restart() {
-    board = std::vector<std::vector<int>>(BOARD_HEIGHT, std::vector<int>(BOARD_WIDTH, 0));
+    resetBoard(boardWidth, boardHeight); // Same size, so the storage is reused
     score = 0;
     lines = 0;
+    finesseErrors = 0;
     fallSpeed = 1.0;
     gameOver = false;
     paused = false;
     gameStarted = true;
-    lastFall = glfwGetTime();
+    lastFall = now;
+    dirty = DIRTY_ALL;
+    if (telemetry) telemetry->emit(TelemetryEvent::GameStart);
     spawnNewPiece();
-    generateNextPiece();
 }
 
 void TetrisGame::startGame() {
     gameStarted = true;
-    lastFall = glfwGetTime();
+    lastFall = now;
+    dirty |= DIRTY_OVERLAY;
+    if (telemetry) telemetry->emit(TelemetryEvent::GameStart);
 }
 
 void TetrisGame::togglePause() {
     if (!gameOver) {
         paused = !paused;
+        dirty |= DIRTY_OVERLAY;
+        if (telemetry) telemetry->emit(paused ? TelemetryEvent::Pause : TelemetryEvent::Resume);
         if (!paused) {
             // Resume the timer to prevent instant drop when unpausing
-            lastFall = glfwGetTime();
+            lastFall = now;
         }
     }
 }
 
-void TetrisGame::render() {
-    glClear(GL_COLOR_BUFFER_BIT);
-    glClearColor(0.15f, 0.15f, 0.15f, 1.0f); // Darker background
+void TetrisGame::toggleGravity20G() {
+    gravity20G = !gravity20G;
+    if (gravity20G && !gameOver) {
+        currentPiece.y += dropDistance(currentPiece);
+        dirty |= DIRTY_PIECE;
+    }
+}
+
+void TetrisGame::saveState(std::string& out) const {
+    ByteWriter writer(out);
+    writer.u16(boardWidth);
+    writer.u32(boardHeight);
+    for (int y = 0; y < boardHeight; y++) {
+        writer.bytes(&cells[(size_t)rowSlot[y] * boardWidth], boardWidth);
+    }
     
-    // Draw the game board
-    for (int y = 0; y < BOARD_HEIGHT; y++) {
-        for (int x = 0; x < BOARD_WIDTH; x++) {
-            if (board[y][x] != 0) {
-                renderer->drawBlock(x, y, COLORS[board[y][x]]);
-            }
+    writer.u8(currentPiece.type);
+    writer.i32(currentPiece.x);
+    writer.i32(currentPiece.y);
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            writer.u8(currentPiece.shape[i][j]);
         }
     }
     
-    // Draw the current piece
-    if (!gameOver) {
-        for (int i = 0; i < 4; i++) {
-            for (int j = 0; j < 4; j++) {
-                if (currentPiece.shape[i][j] != 0) {
-                    int drawX = currentPiece.x + j;
-                    int drawY = currentPiece.y + i;
-                    if (drawX >= 0 && drawX < BOARD_WIDTH && drawY >= 0 && drawY < BOARD_HEIGHT) {
-                        renderer->drawBlock(drawX, drawY, COLORS[currentPiece.shape[i][j]]);
-                    }
-                }
+    writer.u64(seed);
+    writer.u64(queue.getDraws());
+    writer.u8(queue.size());
+    writer.u8((uint8_t)queue.getRandomizer());
+    writer.f64(lastFall);
+    writer.f64(now);
+    writer.f64(fallSpeed);
+    writer.i32(score);
+    writer.i32(lines);
+    writer.i32(finesseErrors);
+    writer.i32(pieceInputs);
+    writer.u8((gameOver ? 1 : 0) | (paused ? 2 : 0) | (gameStarted ? 4 : 0) | (gravity20G ? 8 : 0));
+}
+
+bool TetrisGame::loadState(const std::string& in) {
+    ByteReader reader(in.data(), in.size());
+    int width = reader.u16();
+    int height = reader.u32();
+    if (width < 4 || width > MAX_BOARD_WIDTH || height < 4 || height > MAX_BOARD_HEIGHT ||
+        reader.remaining() < (size_t)width * height) {
+        return false;
+    }
+    resetBoard(width, height);
+    reader.bytes(cells.data(), cells.size());
+    for (int y = 0; y < boardHeight; y++) {
+        for (int x = 0; x < boardWidth; x++) {
+            if (getCell(x, y) != 0) {
+                rowFill[y]++;
+                columnFill[x]++;
             }
         }
     }
     
-    // Draw game board border
-    Color borderColor(0.7f, 0.7f, 0.7f, 1.0f);
-    int borderThickness = 3;
-    // Use UI shader for borders
-    renderer->drawRect(BOARD_OFFSET_X - borderThickness, BOARD_OFFSET_Y - borderThickness, borderThickness, BOARD_HEIGHT * BLOCK_SIZE + 2 * borderThickness, borderColor);
-    renderer->drawRect(BOARD_OFFSET_X + BOARD_WIDTH * BLOCK_SIZE, BOARD_OFFSET_Y - borderThickness, borderThickness, BOARD_HEIGHT * BLOCK_SIZE + 2 * borderThickness, borderColor);
-    renderer->drawRect(BOARD_OFFSET_X - borderThickness, BOARD_OFFSET_Y - borderThickness, BOARD_WIDTH * BLOCK_SIZE + 2 * borderThickness, borderThickness, borderColor);
-    renderer->drawRect(BOARD_OFFSET_X - borderThickness, BOARD_OFFSET_Y + BOARD_HEIGHT * BLOCK_SIZE, BOARD_WIDTH * BLOCK_SIZE + 2 * borderThickness, borderThickness, borderColor);
-    
-    // UI Panel settings
-    float panelX = BOARD_OFFSET_X + BOARD_WIDTH * BLOCK_SIZE + 20;
-    float panelWidth = 180;
-    Color panelBorder(1.0f, 1.0f, 1.0f, 1.0f); // White border only
-    Color textColor(1.0f, 1.0f, 1.0f, 1.0f); // White text
-    Color numberColor(1.0f, 1.0f, 1.0f, 1.0f); // White numbers
-
-    // Next piece panel
-    float nextPanelY = BOARD_OFFSET_Y + BOARD_HEIGHT * BLOCK_SIZE - 120;
-    float nextPanelHeight = 100;
-
-    // Draw only border (no fill) for UI panels
-    renderer->drawRect(panelX, nextPanelY, panelWidth, 3, panelBorder); // Top
-    renderer->drawRect(panelX, nextPanelY + nextPanelHeight - 3, panelWidth, 3, panelBorder); // Bottom
-    renderer->drawRect(panelX, nextPanelY, 3, nextPanelHeight, panelBorder); // Left
-    renderer->drawRect(panelX + panelWidth - 3, nextPanelY, 3, nextPanelHeight, panelBorder); // Right
-
-    // Draw "NEXT" title
-    renderer->drawText("NEXT", panelX + 10, nextPanelY + nextPanelHeight - 30, 18, textColor);
-
-    // Draw next piece preview (use block shader for blocks)
-    float previewX = panelX + 60;
-    float previewY = nextPanelY + 4;
-    int previewSize = 18;
+    currentPiece = TetrisPiece(reader.u8() % 7);
+    currentPiece.x = reader.i32();
+    currentPiece.y = reader.i32();
     for (int i = 0; i < 4; i++) {
         for (int j = 0; j < 4; j++) {
-            if (nextPiece.shape[i][j] != 0) {
-                float blockX = previewX + j * previewSize;
-                float blockY = previewY + (3 - i) * previewSize;
-                glUseProgram(renderer->getBlockShaderProgram());
-                GLint offsetLoc = glGetUniformLocation(renderer->getBlockShaderProgram(), "offset");
-                glUniform2f(offsetLoc, blockX, blockY);
-                GLint scaleLoc = glGetUniformLocation(renderer->getBlockShaderProgram(), "scale");
-                glUniform2f(scaleLoc, previewSize - 2, previewSize - 2);
-                GLint colorLoc = glGetUniformLocation(renderer->getBlockShaderProgram(), "color");
-                Color previewColor = COLORS[nextPiece.shape[i][j]];
-                glUniform4f(colorLoc, previewColor.r, previewColor.g, previewColor.b, previewColor.a);
-                glBindVertexArray(renderer->getVAO());
-                glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+            currentPiece.shape[i][j] = reader.u8();
+        }
+    }
+    currentPiece.updateProfile();
+    
+    // Jump the generator straight to the saved position, the queue is rebuilt from it
+    seed = reader.u64();
+    uint64_t draws = reader.u64();
+    int previewDepth = reader.u8();
+    if (!queue.restore(seed, draws, previewDepth, (Randomizer)reader.u8())) return false;
+    
+    lastFall = reader.f64();
+    now = reader.f64();
+    fallSpeed = reader.f64();
+    score = reader.i32();
+    lines = reader.i32();
+    finesseErrors = reader.i32();
+    pieceInputs = reader.i32();
+    uint8_t flags = reader.u8();
+    gameOver = flags & 1;
+    paused = flags & 2;
+    gameStarted = flags & 4;
+    gravity20G = flags & 8;
+    
+    dirty = DIRTY_ALL;
+    
+    // Column heights are derived state
+    for (int x = 0; x < boardWidth; x++) {
+        for (int y = 0; y < boardHeight; y++) {
+            if (getCell(x, y) != 0) {
+                columnHeights[x] = boardHeight - y;
+                break;
             }
         }
     }
+    return reader.good();
+}
 
-    // Score panel
-    float scorePanelY = nextPanelY - 110;
-    float scorePanelHeight = 70;
-
-    renderer->drawRect(panelX, scorePanelY, panelWidth, 3, panelBorder); // Top
-    renderer->drawRect(panelX, scorePanelY + scorePanelHeight - 3, panelWidth, 3, panelBorder); // Bottom
-    renderer->drawRect(panelX, scorePanelY, 3, scorePanelHeight, panelBorder); // Left
-    renderer->drawRect(panelX + panelWidth - 3, scorePanelY, 3, scorePanelHeight, panelBorder); // Right
-
-    renderer->drawText("SCORE", panelX + 10, scorePanelY + scorePanelHeight - 28, 18, textColor);
-    renderer->drawNumber(score, panelX + 20, scorePanelY + 12, 22, numberColor);
-
-    // Lines panel
-    float linesPanelY = scorePanelY - 90;
-    float linesPanelHeight = 70;
-
-    renderer->drawRect(panelX, linesPanelY, panelWidth, 3, panelBorder); // Top
-    renderer->drawRect(panelX, linesPanelY + linesPanelHeight - 3, panelWidth, 3, panelBorder); // Bottom
-    renderer->drawRect(panelX, linesPanelY, 3, linesPanelHeight, panelBorder); // Left
-    renderer->drawRect(panelX + panelWidth - 3, linesPanelY, 3, linesPanelHeight, panelBorder); // Right
-
-    renderer->drawText("LINES", panelX + 10, linesPanelY + linesPanelHeight - 28, 18, textColor);
-    renderer->drawNumber(lines, panelX + 20, linesPanelY + 12, 22, numberColor);
+// Copies only the rows the renderer can show: the whole board normally, or a
+// window following the falling piece and the stack surface on large boards
+void TetrisGame::snapshot(GameSnapshot& out) const {
+    int cellSize = std::min(BLOCK_SIZE, BOARD_WIDTH * BLOCK_SIZE / boardWidth);
+    int viewRows = std::min(boardHeight, BOARD_HEIGHT * BLOCK_SIZE / std::max(1, cellSize));
     
-    // Show start screen if game hasn't started
-    if (!gameStarted) {
-        Color overlayColor(0.0f, 0.0f, 0.0f, 0.8f);
-        renderer->drawRect(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT, overlayColor);
-        
-        Color titleColor(1.0f, 1.0f, 1.0f, 1.0f);
-        renderer->drawText("TETRIS", WINDOW_WIDTH / 2 - 100, WINDOW_HEIGHT / 2 + 50, 40, titleColor);
-        
-        Color startColor(1.0f, 1.0f, 0.0f, 1.0f);
-        renderer->drawText("PRESS SPACE TO START", WINDOW_WIDTH / 2 - 150, WINDOW_HEIGHT / 2 - 25, 18, startColor);
+    int stackTop = getStackTop();
+    int viewTop = std::min(boardHeight, stackTop + viewRows / 4) - viewRows;
+    if (currentPiece.y < viewTop) {
+        viewTop = currentPiece.y; // Keep the falling piece in view
     }
+    viewTop = std::max(0, std::min(viewTop, boardHeight - viewRows));
     
-    // Show pause indicator if game is paused
-    if (paused && gameStarted) {
-        Color overlayColor(0.0f, 0.0f, 0.0f, 0.7f);
-        renderer->drawRect(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT, overlayColor);
-        
-        Color pauseColor(1.0f, 1.0f, 0.0f, 1.0f);
-        renderer->drawText("PAUSED", WINDOW_WIDTH / 2 - 70, WINDOW_HEIGHT / 2 + 20, 25, pauseColor);
-        
-        Color resumeColor(0.9f, 0.9f, 0.9f, 1.0f);
-        renderer->drawText("PRESS SPACE TO RESUME", WINDOW_WIDTH / 2 - 160, WINDOW_HEIGHT / 2 - 30, 18, resumeColor);
+    out.boardWidth = boardWidth;
+    out.cellSize = cellSize;
+    out.viewTop = viewTop;
+    out.viewRows = viewRows;
+    out.board.resize((size_t)viewRows * boardWidth); // Only grows, snapshots are reused
+    for (int y = 0; y < viewRows; y++) {
+        const unsigned char* row = &cells[(size_t)rowSlot[viewTop + y] * boardWidth];
+        std::copy(row, row + boardWidth, out.board.begin() + (size_t)y * boardWidth);
     }
-    
-    // Show game over screen
-    if (gameOver) {
-        Color overlayColor(0.0f, 0.0f, 0.0f, 0.8f);
-        renderer->drawRect(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT, overlayColor);
-        
-        Color gameOverColor(1.0f, 0.0f, 0.0f, 1.0f);
-        renderer->drawText("GAME OVER", WINDOW_WIDTH / 2 - 90, WINDOW_HEIGHT / 2 + 50, 25, gameOverColor);
-        
-        Color scoreColor(1.0f, 1.0f, 1.0f, 1.0f);
-        renderer->drawText("SCORE:", WINDOW_WIDTH / 2 - 75, WINDOW_HEIGHT / 2, 20, scoreColor);
-        renderer->drawNumber(score, WINDOW_WIDTH / 2 + 20, WINDOW_HEIGHT / 2, 20, scoreColor);
-
-        renderer->drawText("LINES CLEARED:", WINDOW_WIDTH / 2 - 125, WINDOW_HEIGHT / 2 - 50, 20, scoreColor);
-        renderer->drawNumber(lines, WINDOW_WIDTH / 2 + 115, WINDOW_HEIGHT / 2 - 50, 20, scoreColor);
-        
-        Color restartColor(1.0f, 1.0f, 0.0f, 1.0f);
-        renderer->drawText("PRESS R TO RESTART", WINDOW_WIDTH / 2 - 140, WINDOW_HEIGHT / 2 - 100, 18, restartColor);
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            out.current[i][j] = currentPiece.shape[i][j];
+        }
+    }
+    out.previewCount = queue.size();
+    for (int i = 0; i < out.previewCount; i++) {
+        out.preview[i] = queue.peek(i);
     }
+    out.currentX = currentPiece.x;
+    out.currentY = currentPiece.y - viewTop;
+    out.ghostY = (gameOver ? currentPiece.y : currentPiece.y + dropDistance(currentPiece)) - viewTop;
+    out.score = score;
+    out.lines = lines;
+    out.finesseErrors = finesseErrors;
+    out.gameOver = gameOver;
+    out.paused = paused;
+    out.gameStarted = gameStarted;
+    out.nextFall = (gameStarted && !paused && !gameOver) ? lastFall + fallSpeed - now : -1.0;
 }
@@ -1,15 +1,37 @@
 #include "headers/TetrisPiece.h"
 
 TetrisPiece::TetrisPiece(int pieceType) : type(pieceType), x(BOARD_WIDTH/2 - 2), y(0) {
-    shape = PIECES[pieceType];
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            shape[i][j] = PIECES[pieceType][i][j];
+        }
+    }
+    updateProfile();
 }
 
 void TetrisPiece::rotate() {
-    std::vector<std::vector<int>> rotated(4, std::vector<int>(4, 0));
+    int rotated[4][4];
     for (int i = 0; i < 4; i++) {
         for (int j = 0; j < 4; j++) {
             rotated[j][3-i] = shape[i][j];
         }
     }
-    shape = rotated;
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            shape[i][j] = rotated[i][j];
+        }
+    }
+    updateProfile();
+}
+
+void TetrisPiece::updateProfile() {
+    for (int j = 0; j < 4; j++) {
+        bottom[j] = -1;
+        for (int i = 3; i >= 0; i--) {
+            if (shape[i][j] != 0) {
+                bottom[j] = i;
+                break;
+            }
+        }
+    }
 }
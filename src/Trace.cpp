@@ -0,0 +1,140 @@
+#include "headers/Trace.h"
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+// Written by the owning thread, read by a dump from any thread. The sequence number
+// works as a seqlock: a dump discards slots that were overwritten while it copied them.
+struct TraceSlot {
+    std::atomic<uint64_t> sequence; // Zone index + 1, 0 while the slot is being written
+    std::atomic<const char*> name;
+    std::atomic<uint64_t> start;
+    std::atomic<uint64_t> end;
+};
+
+struct TraceBuffer {
+    std::atomic<uint64_t> written; // Zones recorded so far, only the owner writes it
+    uint32_t threadId;
+    std::string threadName; // Guarded by registryMutex
+    TraceSlot slots[TRACE_RING_SIZE];
+};
+
+struct TraceEvent {
+    const char* name;
+    uint64_t start;
+    uint64_t end;
+};
+
+std::mutex registryMutex;
+std::vector<TraceBuffer*> buffers; // Never freed, so zones stay readable after their thread exits
+thread_local TraceBuffer* localBuffer = nullptr;
+
+TraceBuffer* threadBuffer() {
+    if (!localBuffer) {
+        TraceBuffer* buffer = new TraceBuffer(); // Value-initialized: every sequence starts at 0
+        std::lock_guard<std::mutex> lock(registryMutex);
+        buffer->threadId = (uint32_t)buffers.size() + 1;
+        buffers.push_back(buffer);
+        localBuffer = buffer;
+    }
+    return localBuffer;
+}
+
+void writeEscaped(std::FILE* out, const char* text) {
+    for (; *text; text++) {
+        if (*text == '"' || *text == '\\') std::fputc('\\', out);
+        std::fputc(*text, out);
+    }
+}
+
+}
+
+namespace Trace {
+
+std::atomic<bool> enabled(false);
+
+void setEnabled(bool on) {
+    enabled.store(on && TETRIS_TRACE_ENABLED);
+}
+
+bool isEnabled() {
+    return enabled.load();
+}
+
+void setThreadName(const char* name) {
+    TraceBuffer* buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(registryMutex);
+    buffer->threadName = name;
+}
+
+void record(const char* name, uint64_t start, uint64_t end) {
+    TraceBuffer* buffer = threadBuffer();
+    uint64_t index = buffer->written.load(std::memory_order_relaxed);
+    TraceSlot& slot = buffer->slots[index & (TRACE_RING_SIZE - 1)];
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.start.store(start, std::memory_order_relaxed);
+    slot.end.store(end, std::memory_order_relaxed);
+    slot.sequence.store(index + 1, std::memory_order_release);
+    buffer->written.store(index + 1, std::memory_order_release);
+}
+
+bool dumpChromeJson(const std::string& path, double seconds) {
+    std::vector<std::pair<TraceBuffer*, std::string>> threads;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (TraceBuffer* buffer : buffers) {
+            threads.emplace_back(buffer, buffer->threadName);
+        }
+    }
+
+    std::FILE* out = std::fopen(path.c_str(), "w");
+    if (!out) return false;
+    std::fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    uint64_t cutoff = now() - (uint64_t)(seconds * 1e9);
+    std::vector<TraceEvent> events;
+    for (auto& thread : threads) {
+        TraceBuffer* buffer = thread.first;
+        if (!thread.second.empty()) {
+            std::fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"",
+                         first ? "" : ",\n", buffer->threadId);
+            writeEscaped(out, thread.second.c_str());
+            std::fprintf(out, "\"}}");
+            first = false;
+        }
+
+        // Newest first, zones end in recording order so the first one too old ends the walk
+        events.clear();
+        uint64_t written = buffer->written.load(std::memory_order_acquire);
+        uint64_t oldest = written > TRACE_RING_SIZE ? written - TRACE_RING_SIZE : 0;
+        for (uint64_t index = written; index > oldest; index--) {
+            TraceSlot& slot = buffer->slots[(index - 1) & (TRACE_RING_SIZE - 1)];
+            if (slot.sequence.load(std::memory_order_acquire) != index) break; // Overwritten, older ones too
+            TraceEvent event;
+            event.name = slot.name.load(std::memory_order_relaxed);
+            event.start = slot.start.load(std::memory_order_relaxed);
+            event.end = slot.end.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) != index) break;
+            if (event.end < cutoff) break;
+            events.push_back(event);
+        }
+
+        // Complete ("X") events, timestamps in microseconds
+        for (auto it = events.rbegin(); it != events.rend(); ++it) {
+            std::fprintf(out, "%s{\"name\":\"", first ? "" : ",\n");
+            writeEscaped(out, it->name);
+            std::fprintf(out, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", buffer->threadId,
+                         it->start / 1000.0, (it->end - it->start) / 1000.0);
+            first = false;
+        }
+    }
+    std::fprintf(out, "\n]}\n");
+    return std::fclose(out) == 0;
+}
+
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "PieceQueue.h"
+#include "TranspositionTable.h"
+
+class TetrisGame;
+
+const int AI_MAX_WIDTH = 32;  // Rows are 32-bit masks
+const int AI_MAX_HEIGHT = 64;
+const int AI_PIECE_TYPES = 7;
+const float AI_LOST = -1e6f;  // Value of a board the piece cannot be placed on
+
+// Locked cells as one bitmask per row (bit x = column x), row 0 at the top like TetrisGame
+struct AiBoard {
+    int width;
+    int height;
+    uint32_t rows[AI_MAX_HEIGHT];
+
+    // False if the game's board is larger than AI_MAX_WIDTH x AI_MAX_HEIGHT
+    static bool fromGame(const TetrisGame& game, AiBoard& out);
+    int stackTop() const; // First non-empty row, height if the board is empty
+    uint64_t hash() const;
+    bool operator==(const AiBoard& other) const;
+};
+
+struct AiMove {
+    bool valid = false; // False when the piece cannot be placed anywhere
+    int rotations = 0;  // Clockwise rotations at the spawn position
+    int x = 0;          // Column of the 4x4 piece box, as TetrisPiece::x
+    float value = AI_LOST;
+};
+
+struct AiSearchStats {
+    uint64_t nodes = 0;       // Positions expanded
+    uint64_t evaluations = 0; // Boards scored by the heuristic
+    TranspositionStats table;
+
+    void add(const AiSearchStats& other) {
+        nodes += other.nodes;
+        evaluations += other.evaluations;
+        table.add(other.table);
+    }
+};
+
+// Expectimax placement search. Placements follow the game's own moves: rotate at the
+// spawn position, shift sideways, hard drop (no soft-drop tucks). The first levels use
+// the current piece and the preview queue, every deeper level averages over all seven.
+// With a transposition table, positions reached again (by another order of same-type
+// pieces, possibly on another thread) are looked up instead of re-searched; the key
+// includes the remaining depth, so results are the same with or without it. Only searches
+// where a type comes twice before the last piece can reach a position again, so the
+// others (every two-piece search) don't hash or probe at all.
+class AiSearch {
+private:
+    TranspositionTable* table; // Optional, shared with other searches, not owned
+    int threads;
+    AiSearchStats stats; // Of the latest findMove()
+    
+    // threads - 1 helpers started once, each findMove() wakes them with one job
+    std::vector<std::thread> helpers;
+    std::mutex poolMutex;
+    std::condition_variable jobReady;
+    std::condition_variable jobDone;
+    std::function<void(int)> job; // Called with the helper's index, 1..threads - 1
+    uint64_t jobRound;            // Bumped for every job
+    int helpersBusy;
+    bool quitting;
+    
+    void helperLoop(int index);
+
+public:
+    AiSearch(TranspositionTable* table = nullptr, int threads = 1);
+    ~AiSearch();
+    AiSearch(const AiSearch&) = delete;
+    AiSearch& operator=(const AiSearch&) = delete;
+
+    // depth counts pieces: 1 = current only, 2 = current and next, 3+ adds unseen pieces.
+    // Root placements are split across the caller and the helper threads, sharing the table.
+    AiMove findMove(const AiBoard& board, int current, int next, int depth);
+    // Same with up to PIECE_PREVIEW_MAX known upcoming pieces (e.g. a game's whole queue)
+    AiMove findMove(const AiBoard& board, int current, const int* preview, int previewLength, int depth);
+
+    // Board after playing `move` the way the game would, false if the game would block it
+    static bool apply(const AiBoard& board, int type, const AiMove& move, AiBoard& out);
+    // Heuristic score of the stack alone, higher is better
+    static float evaluate(const AiBoard& board);
+
+    const AiSearchStats& getStats() const { return stats; }
+};
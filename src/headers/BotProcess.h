@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+
+// External program driven through its stdin/stdout, one text line per message
+class BotProcess {
+private:
+#ifdef _WIN32
+    void* process; // Process handle, null when not running
+    void* toBot;
+    void* fromBot;
+#else
+    int pid;
+    int toBot;   // Our end of the bot's stdin
+    int fromBot; // Our end of the bot's stdout
+#endif
+    std::string pending; // Received bytes after the last complete line
+
+public:
+    enum ReadResult { Line, Timeout, Closed };
+
+    BotProcess();
+    ~BotProcess();
+    BotProcess(const BotProcess&) = delete;
+    BotProcess& operator=(const BotProcess&) = delete;
+
+    // Runs `command` through the shell (POSIX) or as a CreateProcess command line (Windows)
+    bool start(const std::string& command);
+    // Closes the bot's stdin, gives it a moment to exit, then kills it
+    void stop();
+
+#ifdef _WIN32
+    bool isRunning() const { return process != nullptr; }
+#else
+    bool isRunning() const { return pid > 0; }
+#endif
+    bool sendLine(const std::string& line);
+    // Waits at most timeoutMs for a complete line; the newline is stripped
+    ReadResult readLine(std::string& line, int timeoutMs);
+};
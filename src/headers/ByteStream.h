@@ -0,0 +1,106 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Little-endian binary encoding helpers for replays, keyframes and archives.
+// std::string is used as the byte buffer.
+class ByteWriter {
+private:
+    std::string& out;
+
+public:
+    explicit ByteWriter(std::string& buffer) : out(buffer) {}
+
+    void u8(uint8_t value) { out.push_back((char)value); }
+    void u16(uint16_t value) { for (int i = 0; i < 2; i++) u8((uint8_t)(value >> (8 * i))); }
+    void u32(uint32_t value) { for (int i = 0; i < 4; i++) u8((uint8_t)(value >> (8 * i))); }
+    void u64(uint64_t value) { for (int i = 0; i < 8; i++) u8((uint8_t)(value >> (8 * i))); }
+    void i32(int32_t value) { u32((uint32_t)value); }
+    void f64(double value) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        u64(bits);
+    }
+    void varint(uint64_t value) {
+        while (value >= 0x80) {
+            u8((uint8_t)(value | 0x80));
+            value >>= 7;
+        }
+        u8((uint8_t)value);
+    }
+    void bytes(const void* data, size_t size) { out.append((const char*)data, size); }
+    void str(const std::string& value) {
+        u16((uint16_t)value.size());
+        bytes(value.data(), (uint16_t)value.size());
+    }
+};
+
+// Reading past the end sets the failed flag and returns zeros instead of throwing
+class ByteReader {
+private:
+    const uint8_t* pos;
+    const uint8_t* end;
+    bool failed;
+
+public:
+    ByteReader(const void* data, size_t size) : pos((const uint8_t*)data), end((const uint8_t*)data + size), failed(false) {}
+
+    bool good() const { return !failed; }
+    size_t remaining() const { return end - pos; }
+    const uint8_t* current() const { return pos; }
+
+    uint8_t u8() {
+        if (pos >= end) {
+            failed = true;
+            return 0;
+        }
+        return *pos++;
+    }
+    uint16_t u16() { uint16_t v = 0; for (int i = 0; i < 2; i++) v |= (uint16_t)u8() << (8 * i); return v; }
+    uint32_t u32() { uint32_t v = 0; for (int i = 0; i < 4; i++) v |= (uint32_t)u8() << (8 * i); return v; }
+    uint64_t u64() { uint64_t v = 0; for (int i = 0; i < 8; i++) v |= (uint64_t)u8() << (8 * i); return v; }
+    int32_t i32() { return (int32_t)u32(); }
+    double f64() {
+        uint64_t bits = u64();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t byte = u8();
+            value |= (uint64_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) break;
+        }
+        return value;
+    }
+    bool bytes(void* data, size_t size) {
+        if (remaining() < size) {
+            failed = true;
+            return false;
+        }
+        std::memcpy(data, pos, size);
+        pos += size;
+        return true;
+    }
+    bool skip(size_t size) {
+        if (remaining() < size) {
+            failed = true;
+            return false;
+        }
+        pos += size;
+        return true;
+    }
+    std::string str() {
+        uint16_t size = u16();
+        if (remaining() < size) {
+            failed = true;
+            return std::string();
+        }
+        std::string value((const char*)pos, size);
+        pos += size;
+        return value;
+    }
+};
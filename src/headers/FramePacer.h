@@ -0,0 +1,21 @@
+#pragma once
+#include <chrono>
+
+// Caps the frame rate by sleeping most of the frame and spinning the rest.
+// The spin margin adapts to how late the OS wakes us up, so coarse timers
+// still hit the deadline without burning the whole frame.
+class FramePacer {
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    Clock::duration frameLength; // Zero when uncapped
+    Clock::duration spinMargin;
+    Clock::time_point lastFrame;
+
+public:
+    FramePacer(int maxFps);
+
+    void setMaxFps(int maxFps);
+    // Blocks until one frame length has passed since the previous call returned
+    void waitForNextFrame();
+};
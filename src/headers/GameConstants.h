@@ -4,11 +4,18 @@
 // Game constants
 const int BOARD_WIDTH = 10;
 const int BOARD_HEIGHT = 20;
+const int MAX_BOARD_WIDTH = 128;    // Large-board stress mode limits
+const int MAX_BOARD_HEIGHT = 100000;
 const int BLOCK_SIZE = 30;
 const int WINDOW_WIDTH = 800;
 const int WINDOW_HEIGHT = 700;
 const int BOARD_OFFSET_X = 100;  // Offset from left edge
 const int BOARD_OFFSET_Y = 50;   // Offset from bottom edge
+const int SIM_TICKS_PER_SECOND = 120; // Fixed simulation rate
+const int SIM_MAX_CATCH_UP_TICKS = 5; // Ticks the simulation may run back-to-back after a stall
+const int DEFAULT_MAX_FPS = 60;        // Frame cap, 0 renders as fast as changes arrive
+const double IDLE_WAIT_SECONDS = 0.5;  // Longest the render loop sleeps without events
+const int FINESSE_MAX_ROWS = 64;       // Finesse is only analyzed while the stack is lower than this
 
 // Block Colors
 struct Color {
@@ -17,4 +24,4 @@ struct Color {
 };
 
 extern const Color COLORS[];
-extern const std::vector<std::vector<std::vector<int>>> PIECES;
+extern const int PIECES[7][4][4];
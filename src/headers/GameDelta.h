@@ -0,0 +1,55 @@
+#pragma once
+#include <string>
+#include "ByteStream.h"
+
+// Board changes recorded by TetrisGame between two drains, in the order they happened.
+// Encoded as a byte stream of ops so a tick with nothing locked costs nothing.
+enum class DeltaOp : uint8_t {
+    End = 0,
+    Lock,  // uint8 color, int32 x, int32 y, uint16 shape mask (bit i*4+j = shape[i][j])
+    Clear  // uint8 count, then count uint32 rows, top to bottom (apply in order)
+};
+
+inline uint16_t shapeMask(const int shape[4][4]) {
+    uint16_t mask = 0;
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            if (shape[i][j] != 0) mask |= 1 << (i * 4 + j);
+        }
+    }
+    return mask;
+}
+
+struct GameDelta {
+    std::string ops;
+    bool reset = false; // Board emptied or replaced, the next frame must be a keyframe
+
+    void lock(int color, int x, int y, const int shape[4][4]) {
+        ByteWriter writer(ops);
+        writer.u8((uint8_t)DeltaOp::Lock);
+        writer.u8((uint8_t)color);
+        writer.i32(x);
+        writer.i32(y);
+        writer.u16(shapeMask(shape));
+    }
+
+    void clear(const int* rows, int count) {
+        ByteWriter writer(ops);
+        writer.u8((uint8_t)DeltaOp::Clear);
+        writer.u8((uint8_t)count);
+        for (int i = 0; i < count; i++) {
+            writer.u32(rows[i]);
+        }
+    }
+
+    // Earlier ops are meaningless once the board is replaced
+    void markReset() {
+        ops.clear();
+        reset = true;
+    }
+
+    void clearAll() {
+        ops.clear(); // Keeps the capacity, draining never allocates
+        reset = false;
+    }
+};
@@ -0,0 +1,30 @@
+#pragma once
+#include <vector>
+#include "GameConstants.h"
+#include "PieceQueue.h"
+
+// Immutable copy of everything the renderer needs for one frame.
+// Snapshot slots are reused, so once the board buffer has grown to the
+// viewport size publishing a snapshot never allocates.
+struct GameSnapshot {
+    // Visible window of the board: viewRows rows of boardWidth cells starting at row viewTop.
+    // Piece rows below are relative to viewTop.
+    std::vector<unsigned char> board;
+    int boardWidth;
+    int viewTop;
+    int viewRows;
+    int cellSize; // On-screen block size that fits the board in the standard frame
+    int current[4][4];
+    int preview[PIECE_PREVIEW_MAX]; // Upcoming piece types, next first
+    int previewCount;
+    int currentX, currentY;
+    int ghostY;
+    int score;
+    int lines;
+    int finesseErrors;
+    bool gameOver;
+    bool paused;
+    bool gameStarted;
+    double nextFall; // Seconds until the next gravity step, negative when the game is idle
+    unsigned long long tick; // Simulation tick the snapshot was taken on
+};
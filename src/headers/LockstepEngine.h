@@ -0,0 +1,80 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "TetrisGame.h"
+
+// Actions understood by LockstepEngine::step(), numbered like TETRIS_ACTION_*
+enum LockstepAction : int32_t {
+    LOCKSTEP_NONE = 0,
+    LOCKSTEP_LEFT,
+    LOCKSTEP_RIGHT,
+    LOCKSTEP_ROTATE,
+    LOCKSTEP_SOFT_DROP,
+    LOCKSTEP_HARD_DROP
+};
+
+const int LOCKSTEP_ROW_STRIDE = 32; // Rows per game: the board, 4 floor rows, padding to 64 bytes
+const int LOCKSTEP_WALL = 3;        // Board column x is bit x + LOCKSTEP_WALL of a row
+
+// Many standard-size games stepped together, stored as parallel arrays instead of one
+// TetrisGame each. A row is a 16-bit mask with the walls set, the rows under the board
+// are solid floor, and a piece is a 64-bit mask covering the four rows it spans, so
+// moving and rotating test one 64-bit AND and full rows are found four at a time. Hard
+// drops test eight landing rows per SSE2 compare, and lanes whose gravity timer can't
+// expire this step are skipped with SIMD compares.
+//
+// Every game plays exactly like a TetrisGame driven by the RL environment with the same
+// seed and actions: same pieces, gravity timing, scores, and restart after game over.
+class LockstepEngine {
+private:
+    int count;
+    int32_t ticksPerStep;
+
+    // Hot, touched every step
+    std::vector<uint16_t> rows;   // count * LOCKSTEP_ROW_STRIDE
+    std::vector<uint8_t> type;
+    std::vector<uint8_t> rotation;
+    std::vector<int8_t> pieceX;
+    std::vector<int8_t> pieceY;
+    std::vector<int32_t> fallIn;  // Ticks until gravity next moves the piece
+    std::vector<int32_t> score;
+    std::vector<uint8_t> over;
+
+    // Touched when a piece locks or a game restarts
+    std::vector<PieceQueue> queues;
+    std::vector<int32_t> lines;
+    std::vector<uint64_t> tick;         // Simulation clock of each game
+    std::vector<uint64_t> lastFallTick; // Tick gravity last fired (TetrisGame::lastFall)
+    std::vector<int32_t> scoreBefore; // Scratch for step()
+    std::vector<int32_t> dropping;    // Scratch for step(): games that hard drop
+
+    uint64_t collides(int game, int pieceType, int pieceRotation, int x, int y) const;
+    void spawn(int game);
+    void lockPiece(int game);
+    void dropPiece(int game);
+    void scheduleFall(int game);
+    void runGravity(int game, int32_t ticks);
+    void restart(int game);
+
+public:
+    // Game i is seeded with seedFor(seed, i) and started, like the RL environment's games
+    LockstepEngine(int count, uint64_t seed, int32_t ticksPerStep, int previewDepth = 1,
+                   Randomizer randomizer = Randomizer::Uniform);
+
+    static uint64_t seedFor(uint64_t seed, int index) { return seed + (uint64_t)index * 0x9E3779B97F4A7C15ULL; }
+
+    // Restarts every game, like TetrisGame::restart()
+    void restartAll();
+    // One action per game, then ticksPerStep ticks of gravity. rewards gets the score gained,
+    // dones whether the game ended; ended games are restarted before returning.
+    void step(const int32_t* actions, float* rewards, uint8_t* dones);
+
+    int size() const { return count; }
+    int getScore(int game) const { return score[game]; }
+    int getLines(int game) const { return lines[game]; }
+    int getCurrentType(int game) const { return type[game]; }
+    int getPreviewDepth() const { return queues.empty() ? 0 : queues[0].size(); }
+    int getPreviewType(int game, int index) const { return queues[game].peek(index); } // 0 = next
+    // Locked cells and the falling piece as 0/1 bytes, BOARD_HEIGHT rows of BOARD_WIDTH
+    void writeBoard(int game, uint8_t* locked, uint8_t* falling) const;
+};
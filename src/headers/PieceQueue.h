@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include "PieceRng.h"
+
+const int PIECE_PREVIEW_MAX = 6;
+const int PIECE_QUEUE_CAPACITY = 8; // Power of two above PIECE_PREVIEW_MAX
+
+// Upcoming piece types in a fixed ring buffer, refilled from the generator as pieces
+// are taken. It always holds the latest `depth` draws, so a saved generator position
+// is enough to rebuild it (see restore()).
+class PieceQueue {
+private:
+    uint8_t types[PIECE_QUEUE_CAPACITY];
+    uint8_t head;  // Slot of the next piece
+    uint8_t depth; // Preview length, 1..PIECE_PREVIEW_MAX
+    PieceRng rng;
+
+    void fill() {
+        head = 0;
+        for (int i = 0; i < depth; i++) types[i] = (uint8_t)rng.next();
+    }
+
+public:
+    explicit PieceQueue(uint64_t seed = 0, int previewDepth = 1, Randomizer randomizer = Randomizer::Uniform)
+        : head(0), depth((uint8_t)clampDepth(previewDepth)), rng(seed, randomizer) {
+        fill();
+    }
+
+    static int clampDepth(int previewDepth) {
+        return previewDepth < 1 ? 1 : previewDepth > PIECE_PREVIEW_MAX ? PIECE_PREVIEW_MAX : previewDepth;
+    }
+
+    // Takes the next piece and draws a new one at the back
+    int pop() {
+        int type = types[head];
+        types[(head + depth) & (PIECE_QUEUE_CAPACITY - 1)] = (uint8_t)rng.next();
+        head = (head + 1) & (PIECE_QUEUE_CAPACITY - 1);
+        return type;
+    }
+
+    // Upcoming piece `index`, 0 = next
+    int peek(int index) const { return types[(head + index) & (PIECE_QUEUE_CAPACITY - 1)]; }
+    int size() const { return depth; }
+    Randomizer getRandomizer() const { return rng.randomizer; }
+    uint64_t getDraws() const { return rng.draws; }
+
+    // Queue of a generator that had made `draws` draws, false if that can't be one
+    bool restore(uint64_t seed, uint64_t draws, int previewDepth, Randomizer randomizer) {
+        if (previewDepth != clampDepth(previewDepth) || draws < (uint64_t)previewDepth ||
+            (randomizer != Randomizer::Uniform && randomizer != Randomizer::Bag7)) {
+            return false;
+        }
+        depth = (uint8_t)previewDepth;
+        rng = PieceRng(seed, randomizer);
+        rng.seek(draws - previewDepth);
+        fill();
+        return true;
+    }
+};
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+
+// How piece types are picked from the generator
+enum class Randomizer : uint8_t {
+    Uniform, // Every draw independent, any type equally likely
+    Bag7     // Each run of 7 draws is a shuffled set of all seven types
+};
+
+// Counter-based piece generator: piece k of a seed is a pure function of (seed, k), so
+// any point of a game's piece sequence can be reached in O(1) and the sequence is the
+// same with every compiler and standard library (no std:: engines or distributions).
+//
+// The seed is hashed into a stream key, and draw k is the SplitMix64 output for
+// key + (k + 1) * golden ratio, scaled to 0..6 with a multiply-shift. The 7-bag
+// shuffles bag k / 7 with the outputs for counters 8 * (k / 7) + 1..6 and picks slot k % 7.
+struct PieceRng {
+    uint64_t key;   // Hashed seed
+    uint64_t draws; // Pieces drawn so far, the counter of the next draw
+    Randomizer randomizer;
+    uint64_t bag;     // 7-bag whose order is cached for next(), ~0 = none yet
+    uint8_t order[7];
+
+    static constexpr uint64_t GOLDEN_GAMMA = 0x9E3779B97F4A7C15ULL;
+
+    explicit PieceRng(uint64_t seed = 0, Randomizer randomizer = Randomizer::Uniform)
+        : key(mix(seed)), draws(0), randomizer(randomizer), bag(~0ull), order{} {}
+
+    // SplitMix64 finalizer
+    static uint64_t mix(uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // Value in 0..range-1 from counter `index` of a stream
+    static int uniformAt(uint64_t key, uint64_t index, int range) {
+        uint64_t bits = mix(key + (index + 1) * GOLDEN_GAMMA);
+        return (int)(((bits >> 32) * (uint64_t)range) >> 32);
+    }
+
+    // Fisher-Yates over one bag, a fixed number of steps so it stays O(1)
+    static void shuffleBag(uint64_t key, uint64_t bag, uint8_t order[7]) {
+        for (int i = 0; i < 7; i++) order[i] = (uint8_t)i;
+        for (int i = 6; i > 0; i--) {
+            int j = uniformAt(key, bag * 8 + i, i + 1);
+            uint8_t swapped = order[i];
+            order[i] = order[j];
+            order[j] = swapped;
+        }
+    }
+
+    static int pieceFromKey(uint64_t key, uint64_t index, Randomizer randomizer) {
+        if (randomizer == Randomizer::Uniform) return uniformAt(key, index, 7);
+        uint8_t order[7];
+        shuffleBag(key, index / 7, order);
+        return order[index % 7];
+    }
+
+    // Piece type (0-6) of draw `index` for a seed, without a generator
+    static int pieceAt(uint64_t seed, uint64_t index, Randomizer randomizer = Randomizer::Uniform) {
+        return pieceFromKey(mix(seed), index, randomizer);
+    }
+
+    // Same as pieceFromKey(), shuffling each bag once instead of on every draw
+    int next() {
+        uint64_t index = draws++;
+        if (randomizer == Randomizer::Uniform) return uniformAt(key, index, 7);
+        if (index / 7 != bag) {
+            bag = index / 7;
+            shuffleBag(key, bag, order);
+        }
+        return order[index % 7];
+    }
+    void seek(uint64_t index) { draws = index; }
+};
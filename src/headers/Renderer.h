@@ -2,12 +2,15 @@
 #include <glad/glad.h>
 #include <string>
 #include "GameConstants.h"
+#include "GameSnapshot.h"
 
 class Renderer {
 private:
     GLuint blockShaderProgram; // bevel effect for blocks
     GLuint uiShaderProgram;    // plain color for UI
     GLuint VAO, VBO;
+    int cellSize; // Board geometry of the snapshot being drawn
+    int viewRows;
 
 public:
     Renderer();
@@ -19,6 +22,7 @@ public:
     void drawDigit(int digit, float x, float y, float size, const Color& color);
     void drawNumber(int number, float x, float y, float size, const Color& color);
     void drawBlock(int x, int y, const Color& color);
+    void drawGame(const GameSnapshot& state);
     
     GLuint getBlockShaderProgram() const { return blockShaderProgram; }
     GLuint getUIShaderProgram() const { return uiShaderProgram; }
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "TetrisGame.h"
+
+const uint8_t REPLAY_VERSION = 5; // 5: keyframes store the piece queue, 4: counter-based piece generator
+const uint32_t REPLAY_KEYFRAME_INTERVAL = 10 * SIM_TICKS_PER_SECOND; // Full-state keyframe every 10 seconds
+
+struct ReplayEvent {
+    uint32_t tick; // Ticks since the replay started
+    GameAction action;
+};
+
+// State at the start of `tick`, after the first `eventIndex` events were applied
+struct ReplayKeyframe {
+    uint32_t tick;
+    uint32_t eventIndex;
+    std::string state;
+};
+
+// One game: its inputs per simulation tick plus periodic keyframes for seeking
+struct Replay {
+    std::string player;
+    uint64_t seed;
+    uint64_t dateMs;    // Wall-clock start, ms since Unix epoch
+    uint64_t startTick; // Absolute simulation tick of replay tick 0
+    uint32_t ticks;
+    int32_t score;
+    int32_t lines;
+    std::vector<ReplayEvent> events;
+    std::vector<ReplayKeyframe> keyframes;
+
+    Replay() : seed(0), dateMs(0), startTick(0), ticks(0), score(0), lines(0) {}
+
+    void serialize(std::string& out) const;
+    bool deserialize(const void* data, size_t size);
+
+    // Restores `game` to the state at the start of `tick` by loading the nearest
+    // earlier keyframe and re-simulating the remaining ticks
+    bool seek(uint32_t tick, TetrisGame& game) const;
+};
+
+// Builds a Replay from the simulation loop as the game is played
+class ReplayRecorder {
+private:
+    Replay replay;
+    bool recording;
+
+public:
+    ReplayRecorder() : recording(false) {}
+
+    bool isRecording() const { return recording; }
+    void begin(uint64_t tick, const TetrisGame& game, const std::string& player);
+    void beginTick(uint64_t tick, const TetrisGame& game);
+    void record(uint64_t tick, GameAction action);
+    const Replay& finish(uint64_t tick, const TetrisGame& game);
+};
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "MappedFile.h"
+#include "Replay.h"
+
+// Append-only archive of many replays:
+//   <base>.tra  replay blobs back to back
+//   <base>.tri  64-byte header ("TRIX", version, count) followed by one
+//               fixed-size entry per replay, memory-mapped so opening and
+//               filtering never touch the replay data
+// Integers are stored in host (little-endian) order.
+const uint32_t REPLAY_ARCHIVE_VERSION = 1;
+
+struct ReplayIndexEntry {
+    uint64_t offset; // Byte offset of the replay in the data file
+    uint64_t length;
+    uint64_t dateMs;
+    int32_t score;
+    int32_t lines;
+    uint32_t ticks;
+    char player[28]; // Zero-padded, truncated if longer
+};
+static_assert(sizeof(ReplayIndexEntry) == 64, "Index entries must stay 64 bytes");
+
+class ReplayArchive {
+private:
+    std::string dataPath;
+    std::string indexPath;
+    MappedFile index;
+    MappedFile data;
+    size_t count;
+
+    bool mapIndex();
+
+public:
+    ReplayArchive(const std::string& basePath);
+
+    bool open();
+    size_t size() const { return count; }
+    const ReplayIndexEntry& entry(size_t i) const;
+    bool load(size_t i, Replay& replay);
+    bool extract(size_t i, std::string& blob);
+    bool append(const Replay& replay);
+};
@@ -0,0 +1,139 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "GameDelta.h"
+#include "SpscRing.h"
+#include "TetrisGame.h"
+
+// Spectator stream, server to spectator only (all integers little endian):
+//   frame:    uint32 size of the rest, uint8 kind ('K' keyframe, 'D' delta), uint64 tick, payload
+//   keyframe: uint16 width, uint32 height, uint32 first row holding cells,
+//             the cells of the rows from there to the bottom, then a state block with every field
+//   delta:    GameDelta ops up to DeltaOp::End, then a state block with the fields that changed
+//   state:    uint8 field mask, then the present fields in this order:
+//             STATE_PIECE  uint8 color, int32 x, int32 y, uint16 shape mask
+//             STATE_NEXT   uint8 next piece type
+//             STATE_SCORE  int32 score, int32 lines
+//             STATE_FLAGS  uint8 (1 game over, 2 paused, 4 started)
+const int SPECTATOR_FLUSH_HZ = 30;                       // Spectators get batched frames at this rate
+const size_t SPECTATOR_MAX_QUEUED_BYTES = 256 * 1024;    // Beyond this a client is resynced
+const int SPECTATOR_MAX_RESYNCS = 3;                     // Resyncs without draining before a client is dropped
+
+enum SpectatorStateFields : uint8_t {
+    STATE_PIECE = 1,
+    STATE_NEXT = 2,
+    STATE_SCORE = 4,
+    STATE_FLAGS = 8,
+    STATE_ALL = 15
+};
+
+struct SpectatorPieceState {
+    int color = 0;
+    int x = 0;
+    int y = 0;
+    uint16_t mask = 0;
+    int nextType = 0;
+    int score = 0;
+    int lines = 0;
+    uint8_t flags = 0;
+};
+
+// Spectator-side copy of the game, rebuilt purely from frames.
+// The server keeps one too, to produce keyframes for clients that join or fall behind.
+class SpectatorView {
+private:
+    void readState(ByteReader& reader);
+
+public:
+    int width;
+    int height;
+    int top; // Rows above this are empty
+    std::vector<unsigned char> cells; // Row-major
+    SpectatorPieceState state;
+    uint64_t tick;
+
+    SpectatorView() : width(0), height(0), top(0), tick(0) {}
+
+    // `frame` starts at the kind byte (after the size prefix)
+    bool applyFrame(const uint8_t* frame, size_t size);
+    void encodeKeyframe(std::string& out) const;
+
+    int getCell(int x, int y) const { return cells[(size_t)y * width + x]; }
+};
+
+// Turns the game's change log into frames, on the simulation thread
+class SpectatorEncoder {
+private:
+    SpectatorPieceState sent;
+    bool needKeyframe;
+
+public:
+    SpectatorEncoder() : needKeyframe(true) {}
+
+    void requestKeyframe() { needKeyframe = true; }
+    void encode(uint64_t tick, const TetrisGame& game, GameDelta& delta, std::string& out);
+};
+
+// Streams the live game to any number of TCP spectators. The simulation thread only
+// encodes a small delta and pushes it into a ring; an epoll loop on its own thread
+// batches the frames, encodes each batch once and shares it between all connections.
+// Linux only, start() fails elsewhere.
+class SpectatorServer {
+private:
+    struct Client {
+        int fd;
+        std::deque<std::shared_ptr<const std::string>> queue;
+        size_t offset; // Bytes of queue.front() already sent
+        size_t queued; // Bytes not yet sent
+        bool writable;
+        int resyncs;
+        bool synced; // Has been sent a keyframe
+    };
+
+    // Simulation thread
+    GameDelta delta;
+    SpectatorEncoder encoder;
+    SpscRing<std::string*, 1024> frames;   // Encoded frames, to the server thread
+    SpscRing<std::string*, 1024> recycled; // Consumed frame buffers, back to the simulation thread
+
+    // Server thread
+    SpectatorView mirror;
+    std::shared_ptr<const std::string> keyframe; // Cached until the mirror changes
+    std::vector<Client*> clients;                // Indexed by fd
+    std::atomic<size_t> clientCount;
+    int listenFd;
+    int epollFd;
+
+    std::atomic<bool> running;
+    std::thread thread;
+
+    void serverLoop();
+    void acceptClients();
+    void closeClient(Client* client);
+    void readClient(Client* client);
+    void flushClient(Client* client);
+    bool enqueue(Client* client, const std::shared_ptr<const std::string>& data);
+    const std::shared_ptr<const std::string>& currentKeyframe();
+
+public:
+    SpectatorServer();
+    ~SpectatorServer();
+    SpectatorServer(const SpectatorServer&) = delete;
+    SpectatorServer& operator=(const SpectatorServer&) = delete;
+
+    bool start(int port);
+    void stop();
+
+    // Hand to TetrisGame::setDeltaLog before the first publish
+    GameDelta* getDeltaLog() { return &delta; }
+
+    // Called from the simulation thread after a tick that changed the game; never blocks
+    void publish(uint64_t tick, const TetrisGame& game);
+
+    size_t getClientCount() const { return clientCount; }
+};
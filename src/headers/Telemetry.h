@@ -0,0 +1,74 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "SpscRing.h"
+
+// Binary log layout (all integers little endian):
+//   header: "TTEL", uint8 version, uint64 session start (ms since Unix epoch)
+//   record: uint8 event, varint microseconds since previous record,
+//           then one zigzag varint per event argument (see TELEMETRY_EVENTS)
+const uint8_t TELEMETRY_VERSION = 1;
+
+enum class TelemetryEvent : uint8_t {
+    GameStart = 0,
+    PieceSpawned,
+    PieceLocked,
+    LinesCleared,
+    LevelChange,
+    Pause,
+    Resume,
+    GameOver,
+    TickDuration,
+    Dropped,
+    Count
+};
+
+struct TelemetryEventInfo {
+    const char* name;
+    int argCount;
+    const char* argNames[3];
+};
+
+extern const TelemetryEventInfo TELEMETRY_EVENTS[];
+
+class Telemetry {
+private:
+    struct Record {
+        uint64_t time; // Nanoseconds since session start
+        TelemetryEvent event;
+        int32_t args[3];
+    };
+
+    SpscRing<Record, 1 << 14> ring;
+    std::FILE* file;
+    std::chrono::steady_clock::time_point start;
+    uint64_t lastTime; // Microseconds of the last written record, flusher thread only
+    std::vector<uint8_t> buffer; // Flusher thread only
+    std::atomic<uint64_t> dropped;
+    std::atomic<bool> running;
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    std::thread flusher;
+
+    void flushLoop();
+    void drain();
+    void writeVarint(uint64_t value);
+    void writeRecord(const Record& record);
+
+public:
+    Telemetry(const std::string& path);
+    ~Telemetry();
+
+    bool isOpen() const { return file != nullptr; }
+    uint64_t getDropped() const { return dropped.load(std::memory_order_relaxed); }
+
+    // Called from the game thread only; never blocks, drops the event if the ring is full
+    void emit(TelemetryEvent event, int32_t a = 0, int32_t b = 0, int32_t c = 0);
+};
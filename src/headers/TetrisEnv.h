@@ -0,0 +1,71 @@
+#pragma once
+#include <stdint.h>
+
+/*
+ * C API for batched reinforcement-learning environments.
+ * One call steps every environment; observations are written straight into
+ * caller-owned contiguous arrays, and nothing is allocated after creation.
+ */
+
+#ifdef _WIN32
+#define TETRIS_ENV_API __declspec(dllexport)
+#else
+#define TETRIS_ENV_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    TETRIS_ACTION_NONE = 0,
+    TETRIS_ACTION_LEFT,
+    TETRIS_ACTION_RIGHT,
+    TETRIS_ACTION_ROTATE,
+    TETRIS_ACTION_SOFT_DROP,
+    TETRIS_ACTION_HARD_DROP,
+    TETRIS_ACTION_COUNT
+};
+
+enum {
+    TETRIS_ENV_PLANES = 2, /* 0: locked cells, 1: falling piece */
+    TETRIS_ENV_MAX_PREVIEW = 6
+};
+
+enum {
+    TETRIS_RANDOMIZER_UNIFORM = 0, /* Every piece drawn independently */
+    TETRIS_RANDOMIZER_BAG7         /* Each run of 7 pieces holds every type once */
+};
+
+/* Caller-provided output arrays, all indexed by environment first */
+typedef struct TetrisEnvBuffers {
+    uint8_t* board;  /* [num_envs][TETRIS_ENV_PLANES][height][width], 0 or 1 */
+    int32_t* pieces; /* [num_envs][1 + preview depth]: current piece type (0-6), then the queue */
+    float* rewards;  /* [num_envs]: score gained this step */
+    uint8_t* dones;  /* [num_envs]: 1 if the game ended this step and was reset */
+} TetrisEnvBuffers;
+
+typedef struct TetrisEnv TetrisEnv;
+
+/* ticks_per_step: simulation ticks (1/120 s) run after each action, gravity included */
+TETRIS_ENV_API TetrisEnv* tetris_env_create(int32_t num_envs, uint64_t seed, int32_t ticks_per_step);
+/* Same with preview_depth (1-TETRIS_ENV_MAX_PREVIEW) upcoming pieces and a TETRIS_RANDOMIZER_* sequence.
+ * tetris_env_create is preview_depth 1 with the uniform randomizer. */
+TETRIS_ENV_API TetrisEnv* tetris_env_create_ex(int32_t num_envs, uint64_t seed, int32_t ticks_per_step,
+                                               int32_t preview_depth, int32_t randomizer);
+TETRIS_ENV_API void tetris_env_destroy(TetrisEnv* env);
+
+TETRIS_ENV_API int32_t tetris_env_num_envs(const TetrisEnv* env);
+TETRIS_ENV_API int32_t tetris_env_preview_depth(const TetrisEnv* env);
+TETRIS_ENV_API int32_t tetris_env_board_width(void);
+TETRIS_ENV_API int32_t tetris_env_board_height(void);
+
+/* Restarts every environment and writes initial observations (rewards and dones are zeroed) */
+TETRIS_ENV_API void tetris_env_reset(TetrisEnv* env, const TetrisEnvBuffers* out);
+
+/* actions: [num_envs] TETRIS_ACTION_* values. Finished games are reset automatically. */
+TETRIS_ENV_API void tetris_env_step(TetrisEnv* env, const int32_t* actions, const TetrisEnvBuffers* out);
+
+#ifdef __cplusplus
+}
+#endif
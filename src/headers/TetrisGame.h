@@ -1,38 +1,87 @@
 #pragma once
 #include <vector>
-#include <random>
 #include <chrono>
+#include <string>
 #include "TetrisPiece.h"
-#include "Renderer.h"
+#include "GameSnapshot.h"
+#include "Telemetry.h"
+#include "GameDelta.h"
 #include "GameConstants.h"
+#include "PieceQueue.h"
+
+// Player inputs, queued by the input thread and applied by the simulation
+enum class GameAction : unsigned char {
+    MoveLeft,
+    MoveRight,
+    SoftDrop,
+    Rotate,
+    HardDrop,
+    Restart,
+    StartOrPause,
+    ToggleGravity20G
+};
+
+// What changed since the renderer last looked, see TetrisGame::takeDirty()
+enum DirtyFlags : unsigned {
+    DIRTY_PIECE = 1,   // Falling or next piece moved/changed
+    DIRTY_BOARD = 2,   // Locked cells changed
+    DIRTY_SCORE = 4,   // Score or lines changed
+    DIRTY_OVERLAY = 8, // Start, pause or game over screen toggled
+    DIRTY_ALL = 15
+};
 
 class TetrisGame {
 private:
-    std::vector<std::vector<int>> board;
+    // Rows are addressed through rowSlot, so clearing lines only moves row indices, never cell data
+    int boardWidth;
+    int boardHeight;
+    std::vector<unsigned char> cells; // boardHeight physical rows of boardWidth cells
+    std::vector<int> rowSlot;         // Logical row (0 = top) -> physical row in cells
+    std::vector<int> rowFill;         // Filled cells per physical row
+    std::vector<int> columnHeights;   // Filled height of each column, kept in sync by placePiece/clearLines
+    std::vector<int> columnFill;      // Filled cells per column, so clearLines knows when a column empties
     TetrisPiece currentPiece;
-    TetrisPiece nextPiece;
-    std::mt19937 rng;
-    std::uniform_int_distribution<int> pieceDist;
+    unsigned long long seed;
+    PieceQueue queue; // Upcoming pieces; saved games store the generator position, restoring it is O(1)
     double lastFall;
+    double now; // Simulation time of the latest update
     double fallSpeed;
     int score;
     int lines;
     bool gameOver;
     bool paused;
     bool gameStarted;
+    bool gravity20G; // Pieces spawn and move directly on their landing row
+    
+    unsigned dirty; // DirtyFlags accumulated since the last takeDirty()
     
-    Renderer* renderer;
+    // Finesse: move and rotate inputs on the current piece versus the fewest that reach its placement.
+    // The search buffers are sized with the board so analyzing a lock never allocates.
+    int pieceInputs;
+    int finesseErrors; // Inputs beyond the optimum, summed over all locked pieces
+    bool finesseTracking; // Off unless set: the search costs more than the rest of a headless step
+    std::vector<uint64_t> finesseVisited; // Bitset over (rotation, row, column) piece states
+    std::vector<int> finesseQueue;
+    
+    Telemetry* telemetry; // Optional event sink, not owned
+    GameDelta* delta;     // Optional board change log for spectators, not owned
 
 public:
     TetrisGame();
+    TetrisGame(unsigned long long seed, int width = BOARD_WIDTH, int height = BOARD_HEIGHT, int previewDepth = 1,
+               Randomizer randomizer = Randomizer::Uniform);
     ~TetrisGame();
     
     void spawnNewPiece();
-    void generateNextPiece();
-    bool checkCollision(const TetrisPiece& piece, int dx, int dy);
+    bool checkCollision(const TetrisPiece& piece, int dx, int dy) const;
+    bool checkCollision(const int cells[4][2], int x, int y) const; // Cell offsets as {column, row}
+    int dropDistance(const TetrisPiece& piece) const;
     void placePiece();
+    int finesseOptimum();
+    void resetBoard(int width, int height);
     void clearLines();
     void update(double currentTime);
+    void apply(GameAction action);
     
     // Movement functions
     void moveLeft();
@@ -45,14 +94,41 @@ public:
     void restart();
     void startGame();
     void togglePause();
+    void toggleGravity20G();
+    
+    void setTelemetry(Telemetry* sink) { telemetry = sink; }
+    void setDeltaLog(GameDelta* log) { delta = log; }
+    // Finesse errors are only counted while tracking is on; off, the total stays where it is
+    void setFinesseTracking(bool enabled) { finesseTracking = enabled; }
+    
+    // Returns and clears the DirtyFlags raised since the previous call
+    unsigned takeDirty() {
+        unsigned changes = dirty;
+        dirty = 0;
+        return changes;
+    }
+    
+    // Keyframes: full game state, restorable on another instance
+    void saveState(std::string& out) const;
+    bool loadState(const std::string& in);
     
     // Rendering
-    void render();
+    void snapshot(GameSnapshot& out) const;
     
     // Getters
     bool isGameOver() const { return gameOver; }
     bool isPaused() const { return paused; }
     bool hasStarted() const { return gameStarted; }
+    bool isGravity20G() const { return gravity20G; }
     int getScore() const { return score; }
     int getLines() const { return lines; }
+    int getFinesseErrors() const { return finesseErrors; }
+    int getBoardWidth() const { return boardWidth; }
+    int getBoardHeight() const { return boardHeight; }
+    int getStackTop() const; // First row that can hold a cell
+    int getCell(int x, int y) const { return cells[rowSlot[y] * boardWidth + x]; }
+    const TetrisPiece& getCurrentPiece() const { return currentPiece; }
+    const PieceQueue& getQueue() const { return queue; }
+    int getNextType() const { return queue.peek(0); }
+    unsigned long long getSeed() const { return seed; }
 };
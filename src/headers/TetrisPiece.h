@@ -4,9 +4,11 @@
 
 class TetrisPiece {
 public:
-    std::vector<std::vector<int>> shape;
+    int shape[4][4]; // Fixed size, copying a piece never allocates
     int x, y, type;
+    int bottom[4]; // Lowest filled row per shape column, -1 if the column is empty
     
     TetrisPiece(int pieceType);
     void rotate();
+    void updateProfile();
 };
@@ -0,0 +1,58 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Scoped timing zones for finding stutters: TRACE_ZONE("name") records how long the
+// enclosing scope took into a ring buffer owned by the current thread, and
+// Trace::dumpChromeJson() writes the recent history as Chrome trace_event JSON
+// (open it in Perfetto or chrome://tracing).
+//
+// Zones compile to nothing in release builds (NDEBUG) unless TETRIS_TRACE is defined,
+// and cost a single relaxed load until Trace::setEnabled(true) is called.
+// Zone names must be string literals.
+#if !defined(NDEBUG) || defined(TETRIS_TRACE)
+#define TETRIS_TRACE_ENABLED 1
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_ZONE(name) TraceZone TRACE_CONCAT(traceZone, __LINE__)(name)
+#else
+#define TETRIS_TRACE_ENABLED 0
+#define TRACE_ZONE(name) ((void)0)
+#endif
+
+const size_t TRACE_RING_SIZE = 1 << 15;   // Zones kept per thread
+const double TRACE_DEFAULT_SECONDS = 10;  // History written by a dump
+
+namespace Trace {
+    extern std::atomic<bool> enabled;
+
+    inline uint64_t now() {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void setEnabled(bool on);
+    bool isEnabled();
+    // Shown as the thread's name in the timeline
+    void setThreadName(const char* name);
+    void record(const char* name, uint64_t start, uint64_t end);
+    // Writes the zones that ended in the last `seconds`, from every thread
+    bool dumpChromeJson(const std::string& path, double seconds = TRACE_DEFAULT_SECONDS);
+}
+
+class TraceZone {
+private:
+    const char* name;
+    uint64_t start;
+
+public:
+    explicit TraceZone(const char* zoneName)
+        : name(zoneName), start(Trace::enabled.load(std::memory_order_relaxed) ? Trace::now() : 0) {}
+    ~TraceZone() {
+        if (start != 0) Trace::record(name, start, Trace::now());
+    }
+    TraceZone(const TraceZone&) = delete;
+    TraceZone& operator=(const TraceZone&) = delete;
+};
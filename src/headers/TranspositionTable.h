@@ -0,0 +1,143 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+// Counters kept by each search thread and merged into the table when its search ends,
+// so probing only ever touches the bucket itself
+struct TranspositionStats {
+    uint64_t probes = 0;
+    uint64_t hits = 0;
+    uint64_t stores = 0;
+    uint64_t collisions = 0; // Stores that evicted a different position of the current search
+
+    void add(const TranspositionStats& other) {
+        probes += other.probes;
+        hits += other.hits;
+        stores += other.stores;
+        collisions += other.collisions;
+    }
+    double hitRate() const { return probes ? (double)hits / probes : 0.0; }
+};
+
+// Fixed-size table of search results, shared by every search thread without locks.
+// An entry is two 64-bit words and its key is stored XORed with the data, so a reader
+// that sees half of a concurrent write gets a key mismatch and treats it as a miss.
+// Four entries fill one cache line; a full bucket evicts entries left over from older
+// searches first, then the shallowest one (the cheapest to recompute). Keys must not be 0.
+class TranspositionTable {
+private:
+    struct Entry {
+        std::atomic<uint64_t> check; // key ^ data
+        std::atomic<uint64_t> data;  // Value bits, depth + 1 (0 = empty) and generation
+    };
+    struct alignas(64) Bucket {
+        Entry entries[4];
+    };
+
+    std::unique_ptr<Bucket[]> buckets;
+    size_t mask;
+    std::atomic<uint32_t> generation;
+    std::atomic<uint64_t> probes, hits, stores, collisions;
+
+    static uint64_t pack(float value, int depth, uint32_t age) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits | (uint64_t)(depth + 1) << 32 | (uint64_t)(age & 0xff) << 40;
+    }
+    static int depthOf(uint64_t data) { return (int)(data >> 32 & 0xff); } // 0 for an empty entry
+    static uint32_t ageOf(uint64_t data) { return (uint32_t)(data >> 40 & 0xff); }
+
+public:
+    // Rounded down to a power of two buckets
+    explicit TranspositionTable(size_t megabytes) : generation(0), probes(0), hits(0), stores(0), collisions(0) {
+        size_t count = 1;
+        while (count * 2 * sizeof(Bucket) <= megabytes * 1024 * 1024) count *= 2;
+        buckets.reset(new Bucket[count]()); // Value-initialized: every entry starts empty
+        mask = count - 1;
+    }
+
+    // Not safe while a search is running
+    void clear() {
+        for (size_t i = 0; i <= mask; i++) {
+            for (Entry& entry : buckets[i].entries) {
+                entry.check.store(0, std::memory_order_relaxed);
+                entry.data.store(0, std::memory_order_relaxed);
+            }
+        }
+        probes = hits = stores = collisions = 0;
+    }
+
+    // Called before each search: older entries stay usable but are replaced first
+    void newSearch() { generation.fetch_add(1, std::memory_order_relaxed); }
+
+    // Starts loading the key's bucket, for callers that know their next probes in advance
+    void prefetch(uint64_t key) const {
+#if defined(__GNUC__)
+        __builtin_prefetch(&buckets[key & mask]);
+#endif
+    }
+
+    bool probe(uint64_t key, int depth, float& value, TranspositionStats& stats) const {
+        stats.probes++;
+        const Bucket& bucket = buckets[key & mask];
+        for (const Entry& entry : bucket.entries) {
+            uint64_t data = entry.data.load(std::memory_order_relaxed);
+            uint64_t check = entry.check.load(std::memory_order_relaxed);
+            if ((check ^ data) == key && depthOf(data) == depth + 1) {
+                uint32_t bits = (uint32_t)data;
+                std::memcpy(&value, &bits, sizeof(value));
+                stats.hits++;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void store(uint64_t key, int depth, float value, TranspositionStats& stats) {
+        uint32_t age = generation.load(std::memory_order_relaxed) & 0xff;
+        Bucket& bucket = buckets[key & mask];
+        Entry* victim = nullptr;
+        int victimPriority = 1 << 30;
+        for (Entry& entry : bucket.entries) {
+            uint64_t data = entry.data.load(std::memory_order_relaxed);
+            if ((entry.check.load(std::memory_order_relaxed) ^ data) == key) {
+                victim = &entry; // Same position, refresh it
+                victimPriority = -1;
+                break;
+            }
+            int priority = depthOf(data) == 0 ? 0 : depthOf(data) + (ageOf(data) == age ? 256 : 0);
+            if (priority < victimPriority) {
+                victim = &entry;
+                victimPriority = priority;
+            }
+        }
+        if (victimPriority >= 256) stats.collisions++;
+        stats.stores++;
+        uint64_t data = pack(value, depth, age);
+        victim->data.store(data, std::memory_order_relaxed);
+        victim->check.store(key ^ data, std::memory_order_relaxed);
+    }
+
+    void addStats(const TranspositionStats& stats) {
+        probes.fetch_add(stats.probes, std::memory_order_relaxed);
+        hits.fetch_add(stats.hits, std::memory_order_relaxed);
+        stores.fetch_add(stats.stores, std::memory_order_relaxed);
+        collisions.fetch_add(stats.collisions, std::memory_order_relaxed);
+    }
+
+    // Totals over every search since construction or clear()
+    TranspositionStats getStats() const {
+        TranspositionStats stats;
+        stats.probes = probes.load(std::memory_order_relaxed);
+        stats.hits = hits.load(std::memory_order_relaxed);
+        stats.stores = stores.load(std::memory_order_relaxed);
+        stats.collisions = collisions.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    size_t entryCount() const { return (mask + 1) * 4; }
+    size_t sizeBytes() const { return (mask + 1) * sizeof(Bucket); }
+};
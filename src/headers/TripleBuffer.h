@@ -0,0 +1,37 @@
+#pragma once
+#include <atomic>
+
+// Lock-free triple buffer: one writer fills a back slot and publishes it,
+// one reader always picks up the latest completely written slot.
+// Neither side ever waits for the other.
+template <typename T>
+class TripleBuffer {
+private:
+    static const int FRESH = 4; // Set on the middle index when it holds an unread slot
+
+    T buffers[3];
+    std::atomic<int> middle;
+    int back;  // Writer's slot
+    int front; // Reader's slot
+
+public:
+    TripleBuffer() : buffers(), middle(1), back(0), front(2) {}
+
+    // Writer side
+    T& writeBuffer() { return buffers[back]; }
+    void publish() {
+        int previous = middle.exchange(back | FRESH, std::memory_order_acq_rel);
+        back = previous & 3;
+    }
+
+    // Reader side: returns true if a newer slot was picked up
+    bool update() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH)) {
+            return false;
+        }
+        int previous = middle.exchange(front, std::memory_order_acq_rel);
+        front = previous & 3;
+        return true;
+    }
+    const T& read() const { return buffers[front]; }
+};
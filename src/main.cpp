@@ -1,44 +1,91 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
 #include <iostream>
+#include <thread>
 #include "headers/TetrisGame.h"
+#include "headers/Renderer.h"
+#include "headers/Telemetry.h"
+#include "headers/ReplayArchive.h"
+#include "headers/SpscRing.h"
+#include "headers/TripleBuffer.h"
+#include "headers/FramePacer.h"
+#include "headers/Spectator.h"
+#include "headers/Trace.h"
 
-// Global game instance
+// Global game instance, owned by the simulation thread once it is running
 TetrisGame* game = nullptr;
-bool gameOverPrinted = false;
+Telemetry* telemetry = nullptr;
+ReplayArchive* archive = nullptr; // Finished games are appended here when set
+SpectatorServer* spectators = nullptr;
+std::string playerName = "player";
+
+// Inputs flow from the window thread to the simulation thread,
+// snapshots flow back from the simulation thread to the render loop
+SpscRing<GameAction, 256> inputQueue;
+TripleBuffer<GameSnapshot> snapshots;
+std::atomic<bool> simulationRunning(true);
+
+// Wakes the simulation thread while it sleeps on an idle game
+std::mutex inputMutex;
+std::condition_variable inputReady;
+
+// Set when the window needs repainting without a game change (expose, resize)
+bool windowDamaged = true;
+
+// F12 writes the last few seconds of trace zones, handled by the render loop
+bool traceRequested = false;
+
+void queueAction(GameAction action) {
+    inputQueue.push(action); // Dropped only if 256 inputs pile up within one tick
+    std::lock_guard<std::mutex> lock(inputMutex);
+    inputReady.notify_one();
+}
+
+void refreshCallback(GLFWwindow* window) {
+    windowDamaged = true;
+}
 
 void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
     if (action == GLFW_PRESS || action == GLFW_REPEAT) {
         switch (key) {
             case GLFW_KEY_LEFT:
             case GLFW_KEY_A:
-                game->moveLeft();
+                queueAction(GameAction::MoveLeft);
                 break;
             case GLFW_KEY_RIGHT:
             case GLFW_KEY_D:
-                game->moveRight();
+                queueAction(GameAction::MoveRight);
                 break;
             case GLFW_KEY_DOWN:
             case GLFW_KEY_S:
-                game->softDrop();
+                queueAction(GameAction::SoftDrop);
                 break;
             case GLFW_KEY_UP:
             case GLFW_KEY_W:
-                game->rotate();
+                queueAction(GameAction::Rotate);
                 break;
             case GLFW_KEY_ENTER:
-                game->drop();
+                queueAction(GameAction::HardDrop);
+                break;
+            case GLFW_KEY_G:
+                queueAction(GameAction::ToggleGravity20G);
                 break;
             case GLFW_KEY_R:
-                game->restart();
-                gameOverPrinted = false; // Reset the flag so message can be shown again
+                queueAction(GameAction::Restart);
                 break;
             case GLFW_KEY_SPACE:
-                if (!game->hasStarted()) {
-                    game->startGame();
-                } else {
-                    game->togglePause();
-                }
+                queueAction(GameAction::StartOrPause);
+                break;
+            case GLFW_KEY_F12:
+                if (action == GLFW_PRESS) traceRequested = true;
                 break;
             case GLFW_KEY_ESCAPE:
                 glfwSetWindowShouldClose(window, GLFW_TRUE);
@@ -47,7 +94,140 @@ void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
     }
 }
 
-int main() {
+void saveTrace(const char* path, double seconds) {
+    if (!TETRIS_TRACE_ENABLED) {
+        std::cout << "Tracing is not available in this build (define TETRIS_TRACE)" << std::endl;
+    } else if (!Trace::isEnabled()) {
+        std::cout << "Tracing is off, start with --trace " << path << std::endl;
+    } else if (Trace::dumpChromeJson(path, seconds)) {
+        std::cout << "Trace of the last " << seconds << "s written to " << path << std::endl;
+    } else {
+        std::cerr << "Failed to write trace " << path << std::endl;
+    }
+}
+
+// Runs the game at a fixed tick rate, independent of how long rendering and swapping take
+void simulationLoop() {
+    using Clock = std::chrono::steady_clock;
+    const auto tickLength = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1.0 / SIM_TICKS_PER_SECOND));
+    
+    Trace::setThreadName("simulation");
+    unsigned long long tick = 0;
+    auto nextTick = Clock::now();
+    ReplayRecorder recorder;
+    while (simulationRunning.load(std::memory_order_relaxed)) {
+        // Nothing moves on the start, pause and game over screens: block until a key arrives
+        if (!game->hasStarted() || game->isPaused() || game->isGameOver()) {
+            std::unique_lock<std::mutex> lock(inputMutex);
+            inputReady.wait(lock, [] { return !inputQueue.empty() || !simulationRunning.load(); });
+            nextTick = Clock::now();
+        }
+        
+        { // Scoped so the tick zone ends before the sleep
+            TRACE_ZONE("tick");
+            auto tickStart = Clock::now();
+            if (archive) recorder.beginTick(tick, *game);
+        
+            // Apply every input that arrived since the previous tick
+            GameAction action;
+            while (inputQueue.pop(action)) {
+                bool startsGame = action == GameAction::Restart ||
+                                  (action == GameAction::StartOrPause && !game->hasStarted());
+                if (startsGame && recorder.isRecording()) {
+                    archive->append(recorder.finish(tick, *game)); // Abandoned by a restart
+                }
+                if (!startsGame) recorder.record(tick, action);
+                game->apply(action);
+                if (startsGame && archive) recorder.begin(tick, *game, playerName);
+            }
+            game->update((double)tick / SIM_TICKS_PER_SECOND);
+            if (game->isGameOver() && recorder.isRecording()) {
+                archive->append(recorder.finish(tick, *game));
+            }
+        
+            // Only publish (and wake the render loop) when something visible changed
+            if (game->takeDirty()) {
+                TRACE_ZONE("publish");
+                GameSnapshot& state = snapshots.writeBuffer();
+                game->snapshot(state);
+                state.tick = tick;
+                snapshots.publish();
+                glfwPostEmptyEvent();
+                if (spectators) spectators->publish(tick, *game);
+            }
+        
+            if (telemetry && game->hasStarted() && !game->isPaused() && !game->isGameOver()) {
+                auto tickTime = Clock::now() - tickStart;
+                telemetry->emit(TelemetryEvent::TickDuration,
+                                (int32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(tickTime).count());
+            }
+        }
+        
+        tick++;
+        nextTick += tickLength;
+        auto current = Clock::now();
+        if (current - nextTick > tickLength * SIM_MAX_CATCH_UP_TICKS) {
+            nextTick = current; // Fell too far behind (e.g. suspended), don't fast-forward
+        }
+        std::this_thread::sleep_until(nextTick);
+    }
+    
+    if (recorder.isRecording()) {
+        archive->append(recorder.finish(tick - 1, *game)); // Window closed mid-game
+    }
+}
+
+int main(int argc, char** argv) {
+    // Command line options
+    const char* telemetryPath = nullptr;
+    const char* archivePath = nullptr;
+    int maxFps = DEFAULT_MAX_FPS;
+    int spectatePort = 0;
+    int boardWidth = BOARD_WIDTH;
+    int boardHeight = BOARD_HEIGHT;
+    int previewDepth = 1;
+    Randomizer randomizer = Randomizer::Uniform;
+    const char* tracePath = "trace.json";
+    double traceSeconds = TRACE_DEFAULT_SECONDS;
+    bool traceOnExit = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--telemetry") == 0 && i + 1 < argc) {
+            telemetryPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--archive") == 0 && i + 1 < argc) {
+            archivePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--player") == 0 && i + 1 < argc) {
+            playerName = argv[++i];
+        } else if (std::strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+            maxFps = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--spectate") == 0 && i + 1 < argc) {
+            spectatePort = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--board") == 0 && i + 1 < argc) {
+            // Stress mode, e.g. --board 100x10000 (clamped to MAX_BOARD_WIDTH x MAX_BOARD_HEIGHT)
+            if (std::sscanf(argv[++i], "%dx%d", &boardWidth, &boardHeight) != 2) {
+                std::cerr << "Expected --board WIDTHxHEIGHT" << std::endl;
+                return -1;
+            }
+        } else if (std::strcmp(argv[i], "--preview") == 0 && i + 1 < argc) {
+            previewDepth = PieceQueue::clampDepth(std::atoi(argv[++i])); // Pieces shown in the NEXT panel, 1-6
+        } else if (std::strcmp(argv[i], "--bag") == 0) {
+            randomizer = Randomizer::Bag7; // Every 7 pieces contain each type once
+        } else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            // Record zones in any build that has them and also write the trace on exit
+            tracePath = argv[++i];
+            traceOnExit = true;
+        } else if (std::strcmp(argv[i], "--trace-seconds") == 0 && i + 1 < argc) {
+            traceSeconds = std::atof(argv[++i]);
+        }
+    }
+    
+    // Debug builds always record, so F12 can capture a stutter after the fact
+#ifndef NDEBUG
+    Trace::setEnabled(true);
+#endif
+    if (traceOnExit) Trace::setEnabled(true);
+    Trace::setThreadName("render");
+    
     // Initialize GLFW
     if (!glfwInit()) {
         std::cerr << "Failed to initialize GLFW" << std::endl;
@@ -69,6 +249,7 @@ int main() {
     
     glfwMakeContextCurrent(window);
     glfwSetKeyCallback(window, keyCallback);
+    glfwSetWindowRefreshCallback(window, refreshCallback);
     
     // Initialize GLAD
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
@@ -83,8 +264,39 @@ int main() {
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     
-    // Create game instance
-    game = new TetrisGame();
+    // Create renderer (needs the GL context) and game instance
+    Renderer* renderer = new Renderer();
+    game = new TetrisGame(std::chrono::steady_clock::now().time_since_epoch().count(), boardWidth, boardHeight,
+                          previewDepth, randomizer);
+    game->setFinesseTracking(true); // Shown in the finesse panel
+    
+    // Structured event log, drained to disk by a background thread
+    if (telemetryPath) {
+        telemetry = new Telemetry(telemetryPath);
+        if (!telemetry->isOpen()) {
+            std::cerr << "Failed to open telemetry log " << telemetryPath << std::endl;
+        }
+        game->setTelemetry(telemetry);
+    }
+    
+    // Replay archive, every finished game is recorded with keyframes for seeking
+    if (archivePath) {
+        archive = new ReplayArchive(archivePath);
+        archive->open(); // Missing files are created on the first append
+    }
+    
+    // Live stream for spectators, fed from the simulation thread
+    if (spectatePort > 0) {
+        spectators = new SpectatorServer();
+        if (spectators->start(spectatePort)) {
+            game->setDeltaLog(spectators->getDeltaLog());
+            std::cout << "Spectators can connect on port " << spectatePort << std::endl;
+        } else {
+            std::cerr << "Failed to start the spectator server on port " << spectatePort << std::endl;
+            delete spectators;
+            spectators = nullptr;
+        }
+    }
     
     std::cout << "=== RETRO TETRIS ===" << std::endl;
     std::cout << "Controls:" << std::endl;
@@ -93,53 +305,91 @@ int main() {
     std::cout << "S/Down Arrow  - Soft Drop" << std::endl;
     std::cout << "W/Up Arrow    - Rotate" << std::endl;
     std::cout << "Enter         - Hard Drop" << std::endl;
+    std::cout << "G             - Toggle 20G gravity" << std::endl;
     std::cout << "Space         - Pause/Resume" << std::endl;
     std::cout << "R             - Restart (when game over)" << std::endl;
+    std::cout << "F12           - Save trace" << std::endl;
     std::cout << "ESC           - Exit" << std::endl;
     
-    // Game loop
+    // Publish the initial state, then hand the game over to the simulation thread
+    game->takeDirty();
+    game->snapshot(snapshots.writeBuffer());
+    snapshots.publish();
+    if (spectators) spectators->publish(0, *game);
+    std::thread simulation(simulationLoop);
+    
+    // Render loop: only draws when a new snapshot arrived or the window was damaged
+    FramePacer pacer(maxFps);
+    bool pausePrinted = false;
+    bool gameOverPrinted = false;
     while (!glfwWindowShouldClose(window)) {
-        double currentTime = glfwGetTime();
+        // Sleep until input, a published snapshot (posted as an empty event) or the next gravity step
+        double nextFall = snapshots.read().nextFall;
+        glfwWaitEventsTimeout(nextFall >= 0 ? std::min(nextFall, IDLE_WAIT_SECONDS) : IDLE_WAIT_SECONDS);
+        if (traceRequested) {
+            traceRequested = false;
+            saveTrace(tracePath, traceSeconds);
+        }
         
-        // Process input
-        glfwPollEvents();
+        bool changed = snapshots.update();
+        if (!changed && !windowDamaged) continue;
         
-        // Update game
-        game->update(currentTime);
+        {
+            TRACE_ZONE("frame pacing");
+            pacer.waitForNextFrame();
+        }
+        snapshots.update(); // Anything published while pacing
+        windowDamaged = false;
         
-        // Render
-        game->render();
+        // Render the latest complete snapshot
+        const GameSnapshot& state = snapshots.read();
+        renderer->drawGame(state);
         
         // Swap buffers
-        glfwSwapBuffers(window);
+        {
+            TRACE_ZONE("swap buffers");
+            glfwSwapBuffers(window);
+        }
         
         // Check for pause state
-        static bool pausePrinted = false;
-        if (!game->isGameOver()) {
-            if (game->isPaused() && !pausePrinted) {
+        if (!state.gameOver) {
+            if (state.paused && !pausePrinted) {
                 std::cout << "\n=== GAME PAUSED ===" << std::endl;
                 std::cout << "Press SPACE to resume" << std::endl;
                 pausePrinted = true;
-            } else if (!game->isPaused() && pausePrinted) {
+            } else if (!state.paused && pausePrinted) {
                 std::cout << "Game resumed!" << std::endl;
                 pausePrinted = false;
             }
         }
         
         // Check for game over
-        if (game->isGameOver()) {
+        if (state.gameOver) {
             if (!gameOverPrinted) {
                 std::cout << "\n=== GAME OVER ===" << std::endl;
-                std::cout << "Final Score: " << game->getScore() << std::endl;
-                std::cout << "Lines Cleared: " << game->getLines() << std::endl;
+                std::cout << "Final Score: " << state.score << std::endl;
+                std::cout << "Lines Cleared: " << state.lines << std::endl;
                 std::cout << "Press R to restart or ESC to quit" << std::endl;
                 gameOverPrinted = true;
             }
+        } else {
+            gameOverPrinted = false; // Reset the flag so message can be shown again
         }
     }
     
     // Cleanup
+    simulationRunning = false;
+    {
+        std::lock_guard<std::mutex> lock(inputMutex);
+        inputReady.notify_one();
+    }
+    simulation.join();
+    if (traceOnExit) saveTrace(tracePath, traceSeconds);
     delete game;
+    delete telemetry;
+    delete archive;
+    delete spectators;
+    delete renderer;
     glfwTerminate();
     return 0;
 }
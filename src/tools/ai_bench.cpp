@@ -0,0 +1,185 @@
+// Plays games with the AI search and compares it with and without the transposition table.
+// Usage: ai_bench [--depths 2,3] [--games 4] [--moves 40] [--threads 1] [--table-mb 64] [--seed 1]
+//                 [--preview 1] [--bag] [--runs 1]
+//
+// Both runs must pick the same moves (the table only skips repeated work), and every
+// placement the search predicts is checked against the board the real game ends up with.
+// With a longer preview the search knows that many more pieces before it has to average.
+// With several runs, each move is timed by its fastest run, which keeps the numbers steady
+// on a busy machine. The table only pays where a search can reach a position twice, so
+// those moves get their own speedup line.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include "../headers/AiSearch.h"
+#include "../headers/TetrisGame.h"
+
+struct BenchOptions {
+    std::vector<int> depths;
+    int games = 4;
+    int moves = 40;
+    int threads = 1;
+    size_t tableMb = 64;
+    unsigned long long seed = 1;
+    int preview = 1;
+    Randomizer randomizer = Randomizer::Uniform;
+    int runs = 1;
+};
+
+struct RunResult {
+    std::vector<AiMove> moves;
+    std::vector<double> moveSeconds;
+    std::vector<bool> probed; // Per move, whether the search looked anything up in the table
+    double seconds = 0;
+    int mispredicted = 0; // Placements where the game's board differs from the search's
+    AiSearchStats stats;
+};
+
+// Same inputs a player would use: rotate at spawn, shift, hard drop
+static void playMove(TetrisGame& game, const AiMove& move) {
+    for (int r = 0; r < move.rotations; r++) game.rotate();
+    while (game.getCurrentPiece().x > move.x) game.moveLeft();
+    while (game.getCurrentPiece().x < move.x) game.moveRight();
+    game.drop();
+}
+
+static RunResult run(const BenchOptions& options, int depth, TranspositionTable* table) {
+    using Clock = std::chrono::steady_clock;
+    RunResult result;
+    AiSearch search(table, options.threads);
+    for (int g = 0; g < options.games; g++) {
+        TetrisGame game(options.seed + g, BOARD_WIDTH, BOARD_HEIGHT, options.preview, options.randomizer);
+        game.startGame();
+        for (int m = 0; m < options.moves && !game.isGameOver(); m++) {
+            AiBoard board, predicted, actual;
+            if (!AiBoard::fromGame(game, board)) {
+                std::cerr << "Board too large for the AI" << std::endl;
+                std::exit(1);
+            }
+            
+            int preview[PIECE_PREVIEW_MAX];
+            const PieceQueue& queue = game.getQueue();
+            for (int i = 0; i < queue.size(); i++) preview[i] = queue.peek(i);
+            
+            auto start = Clock::now();
+            AiMove move = search.findMove(board, game.getCurrentPiece().type, preview, queue.size(), depth);
+            result.moveSeconds.push_back(std::chrono::duration<double>(Clock::now() - start).count());
+            result.seconds += result.moveSeconds.back();
+            result.stats.add(search.getStats());
+            result.probed.push_back(search.getStats().table.probes > 0);
+            result.moves.push_back(move);
+            if (!move.valid) break;
+            
+            AiSearch::apply(board, game.getCurrentPiece().type, move, predicted);
+            playMove(game, move);
+            AiBoard::fromGame(game, actual);
+            if (!(predicted == actual)) result.mispredicted++;
+        }
+    }
+    return result;
+}
+
+// Every run plays the same moves, so the fastest time of each move is kept
+static void keepFastest(RunResult& best, const RunResult& run) {
+    best.seconds = 0;
+    for (size_t m = 0; m < best.moveSeconds.size() && m < run.moveSeconds.size(); m++) {
+        best.moveSeconds[m] = std::min(best.moveSeconds[m], run.moveSeconds[m]);
+        best.seconds += best.moveSeconds[m];
+    }
+}
+
+static void printRun(const char* label, const RunResult& result) {
+    const AiSearchStats& stats = result.stats;
+    std::printf("  %-9s %7.3f ms/move  %10llu nodes  %11llu evaluations", label,
+                result.moves.empty() ? 0.0 : result.seconds * 1000 / result.moves.size(),
+                (unsigned long long)stats.nodes, (unsigned long long)stats.evaluations);
+    if (stats.table.probes > 0) {
+        std::printf("  hit rate %5.1f%%  collisions %llu", stats.table.hitRate() * 100,
+                    (unsigned long long)stats.table.collisions);
+    }
+    std::printf("\n");
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--depths") == 0 && i + 1 < argc) {
+            for (char* list = argv[++i]; *list;) {
+                options.depths.push_back((int)std::strtol(list, &list, 10));
+                if (*list == ',') list++;
+                else if (*list) break;
+            }
+        } else if (std::strcmp(argv[i], "--games") == 0 && i + 1 < argc) {
+            options.games = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--moves") == 0 && i + 1 < argc) {
+            options.moves = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            options.threads = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--table-mb") == 0 && i + 1 < argc) {
+            options.tableMb = (size_t)std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--preview") == 0 && i + 1 < argc) {
+            options.preview = PieceQueue::clampDepth(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--bag") == 0) {
+            options.randomizer = Randomizer::Bag7;
+        } else if (std::strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            options.runs = std::max(1, std::atoi(argv[++i]));
+        } else {
+            std::cerr << "Usage: ai_bench [--depths 2,3] [--games N] [--moves N] [--threads N] [--table-mb N] [--seed N]"
+                         " [--preview N] [--bag] [--runs N]" << std::endl;
+            return 1;
+        }
+    }
+    if (options.depths.empty()) options.depths = {2, 3};
+    
+    bool consistent = true;
+    for (int depth : options.depths) {
+        TranspositionTable table(options.tableMb);
+        std::printf("depth %d, preview %d%s, %d games x %d moves, %d thread(s), table %zu MB (%zu entries), %d run(s)\n",
+                    depth, options.preview, options.randomizer == Randomizer::Bag7 ? " (7-bag)" : "", options.games,
+                    options.moves, options.threads, table.sizeBytes() >> 20, table.entryCount(), options.runs);
+        RunResult plain = run(options, depth, nullptr);
+        RunResult cached = run(options, depth, &table);
+        for (int r = 1; r < options.runs; r++) {
+            // Alternating which goes first keeps either from always running on a warmer machine
+            if (r % 2 == 0) keepFastest(plain, run(options, depth, nullptr));
+            table.clear();
+            keepFastest(cached, run(options, depth, &table));
+            if (r % 2 == 1) keepFastest(plain, run(options, depth, nullptr));
+        }
+        printRun("no table", plain);
+        printRun("table", cached);
+        
+        bool sameMoves = plain.moves.size() == cached.moves.size();
+        for (size_t m = 0; sameMoves && m < plain.moves.size(); m++) {
+            sameMoves = plain.moves[m].rotations == cached.moves[m].rotations && plain.moves[m].x == cached.moves[m].x;
+        }
+        std::printf("  speedup %.2fx, %s moves, %d mispredicted placements\n",
+                    cached.seconds > 0 ? plain.seconds / cached.seconds : 0.0, sameMoves ? "same" : "DIFFERENT",
+                    plain.mispredicted + cached.mispredicted);
+        
+        // Only searches where a type comes twice before the last piece use the table, the
+        // rest run the same code either way
+        double plainProbed = 0, cachedProbed = 0;
+        int probedMoves = 0;
+        for (size_t m = 0; m < cached.probed.size() && m < plain.moveSeconds.size(); m++) {
+            if (!cached.probed[m]) continue;
+            plainProbed += plain.moveSeconds[m];
+            cachedProbed += cached.moveSeconds[m];
+            probedMoves++;
+        }
+        if (probedMoves > 0) {
+            std::printf("  speedup %.2fx on the %d of %zu moves that probed the table\n", plainProbed / cachedProbed,
+                        probedMoves, cached.probed.size());
+        } else {
+            std::printf("  table never probed: no position in a search this deep can be reached twice\n");
+        }
+        consistent = consistent && sameMoves && plain.mispredicted + cached.mispredicted == 0;
+    }
+    return consistent ? 0 : 1;
+}
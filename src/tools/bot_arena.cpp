@@ -0,0 +1,284 @@
+// Plays external bots against the real game rules and summarizes how they did.
+// Usage: bot_arena "<bot command>" [--matches 16] [--jobs 4] [--seed 1] [--budget-ms 100]
+//                  [--startup-ms 5000] [--max-pieces 1000] [--board 10x20] [--preview 1] [--bag]
+//                  [--summary arena.csv]
+//
+// Every match starts its own bot process and talks to it over stdin/stdout, one line per message:
+//   arena: settings <width> <height> <budget ms>        bot: ready
+//   arena: turn <n>
+//          field <rows top to bottom, '.' empty '#' filled, separated by '/'>
+//          current <type 0-6> <x> <y> <4x4 shape rows, separated by '/'>
+//          next <type 0-6> ... (the preview queue, next piece first)
+//          score <score> <lines>
+//          go                                           bot: place <clockwise rotations 0-3> <x>
+//   arena: end <score> <lines> <reason>
+// The arena rotates the piece (4x4 box, no wall kicks), shifts it to x and hard drops it.
+// A move that is blocked on the way is counted as illegal and dropped where it got stuck.
+// Missing the per-move budget, exiting or sending garbage ends the match.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../headers/BotProcess.h"
+#include "../headers/TetrisGame.h"
+
+struct ArenaOptions {
+    std::string command;
+    int matches = 16;
+    int jobs = 4;
+    unsigned long long seed = 1;
+    int budgetMs = 100;
+    int startupMs = 5000;
+    int maxPieces = 1000;
+    int boardWidth = BOARD_WIDTH;
+    int boardHeight = BOARD_HEIGHT;
+    int preview = 1; // Upcoming pieces sent to the bot
+    Randomizer randomizer = Randomizer::Uniform;
+    const char* summaryPath = "arena.csv";
+};
+
+struct MatchResult {
+    unsigned long long seed = 0;
+    int pieces = 0;
+    int score = 0;
+    int lines = 0;
+    int illegal = 0;
+    std::string reason;
+    std::vector<uint32_t> latencies; // Microseconds from "go" to the reply, per move
+};
+
+static std::string fieldLine(const TetrisGame& game) {
+    std::string line = "field ";
+    line.reserve(6 + (size_t)(game.getBoardWidth() + 1) * game.getBoardHeight());
+    for (int y = 0; y < game.getBoardHeight(); y++) {
+        if (y > 0) line += '/';
+        for (int x = 0; x < game.getBoardWidth(); x++) {
+            line += game.getCell(x, y) != 0 ? '#' : '.';
+        }
+    }
+    return line;
+}
+
+static std::string pieceLine(const TetrisPiece& piece) {
+    std::string line = "current " + std::to_string(piece.type) + " " + std::to_string(piece.x) + " " +
+                       std::to_string(piece.y) + " ";
+    for (int i = 0; i < 4; i++) {
+        if (i > 0) line += '/';
+        for (int j = 0; j < 4; j++) {
+            line += piece.shape[i][j] != 0 ? '#' : '.';
+        }
+    }
+    return line;
+}
+
+static std::string queueLine(const PieceQueue& queue) {
+    std::string line = "next";
+    for (int i = 0; i < queue.size(); i++) {
+        line += " " + std::to_string(queue.peek(i));
+    }
+    return line;
+}
+
+// Returns false if the piece was blocked before reaching the requested placement
+static bool applyPlacement(TetrisGame& game, int rotations, int targetX) {
+    bool legal = true;
+    for (int i = 0; i < rotations; i++) {
+        TetrisPiece expected = game.getCurrentPiece();
+        expected.rotate();
+        game.rotate();
+        legal = legal && std::memcmp(expected.shape, game.getCurrentPiece().shape, sizeof(expected.shape)) == 0;
+    }
+    while (game.getCurrentPiece().x != targetX) {
+        int x = game.getCurrentPiece().x;
+        if (targetX < x) {
+            game.moveLeft();
+        } else {
+            game.moveRight();
+        }
+        if (game.getCurrentPiece().x == x) {
+            legal = false;
+            break;
+        }
+    }
+    game.drop();
+    return legal;
+}
+
+static MatchResult playMatch(const ArenaOptions& options, int index) {
+    using Clock = std::chrono::steady_clock;
+    MatchResult result;
+    result.seed = options.seed + index;
+    result.latencies.reserve(options.maxPieces);
+    TetrisGame game(result.seed, options.boardWidth, options.boardHeight, options.preview, options.randomizer);
+    game.startGame();
+    
+    BotProcess bot;
+    std::string reply;
+    if (!bot.start(options.command)) {
+        result.reason = "spawn_failed";
+        return result;
+    }
+    bot.sendLine("settings " + std::to_string(game.getBoardWidth()) + " " + std::to_string(game.getBoardHeight()) +
+                 " " + std::to_string(options.budgetMs));
+    if (bot.readLine(reply, options.startupMs) != BotProcess::Line || reply != "ready") {
+        result.reason = "no_ready";
+        return result;
+    }
+    
+    while (!game.isGameOver() && result.pieces < options.maxPieces) {
+        std::string turn = "turn " + std::to_string(result.pieces + 1) + "\n" + fieldLine(game) + "\n" +
+                           pieceLine(game.getCurrentPiece()) + "\n" +
+                           queueLine(game.getQueue()) + "\n" +
+                           "score " + std::to_string(game.getScore()) + " " + std::to_string(game.getLines()) + "\n" +
+                           "go";
+        if (!bot.sendLine(turn)) {
+            result.reason = "exited";
+            break;
+        }
+        
+        // The budget only covers the bot's thinking, not building the message
+        auto sent = Clock::now();
+        BotProcess::ReadResult status = bot.readLine(reply, options.budgetMs);
+        result.latencies.push_back((uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - sent).count());
+        if (status == BotProcess::Timeout) {
+            result.reason = "timeout";
+            break;
+        }
+        if (status == BotProcess::Closed) {
+            result.reason = "exited";
+            break;
+        }
+        
+        std::istringstream words(reply);
+        std::string verb;
+        int rotations, x;
+        if (!(words >> verb >> rotations >> x) || verb != "place" || rotations < 0 || rotations > 3) {
+            result.reason = "bad_reply";
+            break;
+        }
+        if (!applyPlacement(game, rotations, x)) result.illegal++;
+        result.pieces++;
+    }
+    if (result.reason.empty()) {
+        result.reason = game.isGameOver() ? "top_out" : "max_pieces";
+    }
+    result.score = game.getScore();
+    result.lines = game.getLines();
+    
+    bot.sendLine("end " + std::to_string(result.score) + " " + std::to_string(result.lines) + " " + result.reason);
+    bot.stop();
+    return result;
+}
+
+static uint32_t percentile(std::vector<uint32_t>& values, double fraction) {
+    if (values.empty()) return 0;
+    size_t index = std::min(values.size() - 1, (size_t)(fraction * values.size()));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+static void writeLatencyColumns(std::FILE* out, std::vector<uint32_t> latencies) {
+    uint64_t total = 0;
+    for (uint32_t latency : latencies) total += latency;
+    double mean = latencies.empty() ? 0.0 : (double)total / latencies.size();
+    uint32_t p50 = percentile(latencies, 0.50);
+    uint32_t p99 = percentile(latencies, 0.99);
+    uint32_t max = latencies.empty() ? 0 : *std::max_element(latencies.begin(), latencies.end());
+    std::fprintf(out, "%.1f,%u,%u,%u", mean, p50, p99, max);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: bot_arena \"<bot command>\" [--matches N] [--jobs N] [--seed N] [--budget-ms N]"
+                     " [--startup-ms N] [--max-pieces N] [--board WxH] [--preview N] [--bag] [--summary file.csv]" << std::endl;
+        return 1;
+    }
+    ArenaOptions options;
+    options.command = argv[1];
+    for (int i = 2; i < argc; i++) {
+        if (std::strcmp(argv[i], "--matches") == 0 && i + 1 < argc) {
+            options.matches = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+            options.jobs = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--budget-ms") == 0 && i + 1 < argc) {
+            options.budgetMs = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--startup-ms") == 0 && i + 1 < argc) {
+            options.startupMs = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--max-pieces") == 0 && i + 1 < argc) {
+            options.maxPieces = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--board") == 0 && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%dx%d", &options.boardWidth, &options.boardHeight) != 2) {
+                std::cerr << "Expected --board WIDTHxHEIGHT" << std::endl;
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--preview") == 0 && i + 1 < argc) {
+            options.preview = PieceQueue::clampDepth(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--bag") == 0) {
+            options.randomizer = Randomizer::Bag7;
+        } else if (std::strcmp(argv[i], "--summary") == 0 && i + 1 < argc) {
+            options.summaryPath = argv[++i];
+        }
+    }
+#ifdef SIGPIPE
+    std::signal(SIGPIPE, SIG_IGN); // A bot that exits early shows up as a failed write instead
+#endif
+
+    // Each job plays one match at a time, each match runs its own bot process
+    std::vector<MatchResult> results(options.matches);
+    std::atomic<int> nextMatch(0);
+    std::mutex printMutex;
+    std::vector<std::thread> jobs;
+    for (int j = 0; j < std::min(options.jobs, options.matches); j++) {
+        jobs.emplace_back([&] {
+            for (int index = nextMatch++; index < options.matches; index = nextMatch++) {
+                results[index] = playMatch(options, index);
+                std::lock_guard<std::mutex> lock(printMutex);
+                std::printf("match %d: %s, %d pieces, score %d, lines %d\n", index, results[index].reason.c_str(),
+                            results[index].pieces, results[index].score, results[index].lines);
+            }
+        });
+    }
+    for (std::thread& job : jobs) job.join();
+    
+    std::FILE* out = std::fopen(options.summaryPath, "w");
+    if (!out) {
+        std::cerr << "Cannot write " << options.summaryPath << std::endl;
+        return 1;
+    }
+    std::fprintf(out, "match,seed,result,pieces,score,lines,illegal,moves,latency_mean_us,latency_p50_us,latency_p99_us,latency_max_us\n");
+    std::vector<uint32_t> allLatencies;
+    long long totalScore = 0, totalLines = 0;
+    for (int i = 0; i < options.matches; i++) {
+        const MatchResult& result = results[i];
+        std::fprintf(out, "%d,%llu,%s,%d,%d,%d,%d,%zu,", i, result.seed, result.reason.c_str(), result.pieces,
+                     result.score, result.lines, result.illegal, result.latencies.size());
+        writeLatencyColumns(out, result.latencies);
+        std::fprintf(out, "\n");
+        allLatencies.insert(allLatencies.end(), result.latencies.begin(), result.latencies.end());
+        totalScore += result.score;
+        totalLines += result.lines;
+    }
+    std::fprintf(out, "all,,,,,,,%zu,", allLatencies.size());
+    writeLatencyColumns(out, allLatencies);
+    std::fprintf(out, "\n");
+    std::fclose(out);
+    
+    std::printf("%d matches, mean score %.1f, mean lines %.1f, %zu moves, latency p50 %uus p99 %uus\n",
+                options.matches, options.matches ? (double)totalScore / options.matches : 0.0,
+                options.matches ? (double)totalLines / options.matches : 0.0, allLatencies.size(),
+                percentile(allLatencies, 0.50), percentile(allLatencies, 0.99));
+    std::printf("Summary written to %s\n", options.summaryPath);
+    return 0;
+}
@@ -0,0 +1,158 @@
+// Checks TetrisGame's finesse search against a brute-force reference on random placements.
+// Usage: finesse_check [--placements 4000] [--seed 1]
+//
+// Pieces are steered with random moves, rotations and soft drops, sometimes tucked
+// sideways after landing, and the game's fewest-inputs count for each placement must
+// match a plain 0-1 BFS over every (x, y, rotation) state from spawn. Runs on several
+// board sizes, including one too tall for the game to analyze near the floor.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "../headers/TetrisGame.h"
+
+struct CheckOptions {
+    int placements = 4000; // Per board size
+    unsigned long long seed = 1;
+};
+
+struct PieceState {
+    int x, y, rotation;
+};
+
+// Board cells of a piece, sorted so two placements compare as equal sets
+static std::vector<int> cellsOf(const TetrisPiece& piece, int width) {
+    std::vector<int> cells;
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            if (piece.shape[i][j] != 0) cells.push_back((piece.y + i) * (width + 4) + piece.x + j);
+        }
+    }
+    std::sort(cells.begin(), cells.end());
+    return cells;
+}
+
+// Fewest moves and rotations from spawn to the current piece's cells, falling for free
+static int referenceOptimum(const TetrisGame& game) {
+    int width = game.getBoardWidth(), height = game.getBoardHeight();
+    const TetrisPiece& current = game.getCurrentPiece();
+    std::vector<int> target = cellsOf(current, width);
+    TetrisPiece rotations[4] = {TetrisPiece(current.type), TetrisPiece(current.type), TetrisPiece(current.type),
+                                TetrisPiece(current.type)};
+    for (int r = 1; r < 4; r++) {
+        rotations[r] = rotations[r - 1];
+        rotations[r].rotate();
+    }
+    
+    auto place = [&](const PieceState& state) {
+        TetrisPiece piece = rotations[state.rotation];
+        piece.x = state.x;
+        piece.y = state.y;
+        return piece;
+    };
+    auto index = [&](const PieceState& state) { return (state.rotation * height + state.y) * (width + 4) + state.x + 3; };
+    
+    std::vector<int> cost((size_t)4 * height * (width + 4), -1);
+    std::deque<PieceState> open;
+    PieceState spawn = {width / 2 - 2, 0, 0};
+    if (game.checkCollision(place(spawn), 0, 0)) return -1;
+    cost[index(spawn)] = 0;
+    open.push_back(spawn);
+    while (!open.empty()) {
+        PieceState state = open.front();
+        open.pop_front();
+        int base = cost[index(state)];
+        if (cellsOf(place(state), width) == target) return base;
+        
+        PieceState next[4] = {{state.x, state.y + 1, state.rotation},
+                              {state.x - 1, state.y, state.rotation},
+                              {state.x + 1, state.y, state.rotation},
+                              {state.x, state.y, (state.rotation + 1) & 3}};
+        for (int k = 0; k < 4; k++) {
+            int step = k == 0 ? 0 : 1;
+            if (game.checkCollision(place(next[k]), 0, 0)) continue;
+            int& known = cost[index(next[k])];
+            if (known >= 0 && known <= base + step) continue;
+            known = base + step;
+            if (step == 0) open.push_front(next[k]);
+            else open.push_back(next[k]);
+        }
+    }
+    return -1;
+}
+
+int main(int argc, char** argv) {
+    CheckOptions options;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--placements") == 0 && i + 1 < argc) {
+            options.placements = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            std::cerr << "Usage: finesse_check [--placements N] [--seed N]" << std::endl;
+            return 1;
+        }
+    }
+    
+    using Clock = std::chrono::steady_clock;
+    const int sizes[][2] = {{BOARD_WIDTH, BOARD_HEIGHT}, {4, 20}, {20, 40}, {10, FINESSE_MAX_ROWS + 20}};
+    long checked = 0, skipped = 0, mismatches = 0;
+    double searchSeconds = 0;
+    std::mt19937 rng((uint32_t)options.seed);
+    for (const auto& size : sizes) {
+        TetrisGame game(options.seed, size[0], size[1]);
+        game.setFinesseTracking(true);
+        game.startGame();
+        for (int p = 0; p < options.placements; p++) {
+            if (game.isGameOver()) game.restart();
+            int inputs = (int)(rng() % 8);
+            for (int k = 0; k < inputs; k++) {
+                switch (rng() % 4) {
+                    case 0: game.moveLeft(); break;
+                    case 1: game.moveRight(); break;
+                    case 2: game.rotate(); break;
+                    default: game.softDrop(); break;
+                }
+            }
+            while (!game.checkCollision(game.getCurrentPiece(), 0, 1)) game.softDrop();
+            if (rng() % 3 == 0) {
+                // Tuck: one more input after landing, then fall again
+                switch (rng() % 3) {
+                    case 0: game.moveLeft(); break;
+                    case 1: game.moveRight(); break;
+                    default: game.rotate(); break;
+                }
+                while (!game.checkCollision(game.getCurrentPiece(), 0, 1)) game.softDrop();
+            }
+            
+            auto start = Clock::now();
+            int optimum = game.finesseOptimum();
+            searchSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+            if (optimum < 0 && game.getBoardHeight() - std::max(0, game.getStackTop() - 4) > FINESSE_MAX_ROWS) {
+                skipped++; // Stack too tall to analyze, the game doesn't count this lock
+            } else {
+                int expected = referenceOptimum(game);
+                if (optimum != expected) {
+                    if (mismatches < 5) {
+                        std::printf("  mismatch on %dx%d, placement %d: %d inputs, reference %d\n", size[0], size[1], p,
+                                    optimum, expected);
+                    }
+                    mismatches++;
+                }
+                checked++;
+            }
+            game.drop();
+        }
+        std::printf("%dx%d: %d placements, %d finesse errors counted\n", size[0], size[1], options.placements,
+                    game.getFinesseErrors());
+    }
+    
+    std::printf("%ld placements checked, %ld skipped (stack too tall), %.2f us per search, %ld mismatches\n", checked,
+                skipped, checked + skipped > 0 ? searchSeconds / (checked + skipped) * 1e6 : 0.0, mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,155 @@
+// Steps many games with random actions, once as independent TetrisGame objects and once
+// with the lockstep engine, and compares both the results and the throughput.
+// Usage: lockstep_bench [--games 4096] [--steps 500] [--ticks 8] [--seed 1] [--preview 1] [--bag]
+//
+// The two runs must agree on every reward, game over, score and piece, or the engine
+// has drifted from the game's rules. The TetrisGame baseline runs with finesse tracking
+// off, so the speedup compares the same work.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "../headers/LockstepEngine.h"
+
+struct BenchOptions {
+    int games = 4096;
+    int steps = 500;
+    int ticks = 8;
+    unsigned long long seed = 1;
+    int preview = 1;
+    Randomizer randomizer = Randomizer::Uniform;
+};
+
+struct StepLog {
+    std::vector<float> rewards; // [steps][games]
+    std::vector<uint8_t> dones;
+    double seconds = 0;
+};
+
+// Drop-heavy random play, so games lock pieces, clear the odd line and end regularly
+static std::vector<int32_t> makeActions(const BenchOptions& options) {
+    std::vector<int32_t> actions((size_t)options.steps * options.games);
+    std::mt19937 rng((uint32_t)options.seed);
+    for (int32_t& action : actions) {
+        int roll = (int)(rng() % 8);
+        action = roll < 6 ? roll : LOCKSTEP_HARD_DROP;
+    }
+    return actions;
+}
+
+// The RL environment's original loop: one TetrisGame per environment
+static StepLog runGames(const BenchOptions& options, const std::vector<int32_t>& actions, std::vector<TetrisGame>& games) {
+    using Clock = std::chrono::steady_clock;
+    StepLog log;
+    log.rewards.resize(actions.size());
+    log.dones.resize(actions.size());
+    std::vector<uint64_t> ticks(options.games, 0);
+    games.reserve(options.games);
+    for (int i = 0; i < options.games; i++) {
+        games.emplace_back(LockstepEngine::seedFor(options.seed, i), BOARD_WIDTH, BOARD_HEIGHT, options.preview,
+                           options.randomizer);
+        games.back().setFinesseTracking(false); // The environment never counted finesse, nor does the engine
+        games.back().startGame();
+    }
+    
+    auto start = Clock::now();
+    for (int s = 0; s < options.steps; s++) {
+        for (int i = 0; i < options.games; i++) {
+            size_t index = (size_t)s * options.games + i;
+            TetrisGame& game = games[i];
+            int scoreBefore = game.getScore();
+            switch (actions[index]) {
+                case LOCKSTEP_LEFT: game.apply(GameAction::MoveLeft); break;
+                case LOCKSTEP_RIGHT: game.apply(GameAction::MoveRight); break;
+                case LOCKSTEP_ROTATE: game.apply(GameAction::Rotate); break;
+                case LOCKSTEP_SOFT_DROP: game.apply(GameAction::SoftDrop); break;
+                case LOCKSTEP_HARD_DROP: game.apply(GameAction::HardDrop); break;
+                default: break;
+            }
+            for (int t = 0; t < options.ticks && !game.isGameOver(); t++) {
+                game.update((double)++ticks[i] / SIM_TICKS_PER_SECOND);
+            }
+            log.rewards[index] = (float)(game.getScore() - scoreBefore);
+            log.dones[index] = game.isGameOver();
+            if (game.isGameOver()) game.restart();
+        }
+    }
+    log.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return log;
+}
+
+static StepLog runEngine(const BenchOptions& options, const std::vector<int32_t>& actions, LockstepEngine& engine) {
+    using Clock = std::chrono::steady_clock;
+    StepLog log;
+    log.rewards.resize(actions.size());
+    log.dones.resize(actions.size());
+    
+    auto start = Clock::now();
+    for (int s = 0; s < options.steps; s++) {
+        size_t offset = (size_t)s * options.games;
+        engine.step(&actions[offset], &log.rewards[offset], &log.dones[offset]);
+    }
+    log.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return log;
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--games") == 0 && i + 1 < argc) {
+            options.games = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--steps") == 0 && i + 1 < argc) {
+            options.steps = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+            options.ticks = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--preview") == 0 && i + 1 < argc) {
+            options.preview = PieceQueue::clampDepth(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--bag") == 0) {
+            options.randomizer = Randomizer::Bag7;
+        } else {
+            std::cerr << "Usage: lockstep_bench [--games N] [--steps N] [--ticks N] [--seed N] [--preview N] [--bag]"
+                      << std::endl;
+            return 1;
+        }
+    }
+    if (options.games <= 0 || options.steps <= 0 || options.ticks <= 0) {
+        std::cerr << "games, steps and ticks must be positive" << std::endl;
+        return 1;
+    }
+    
+    std::vector<int32_t> actions = makeActions(options);
+    std::vector<TetrisGame> games;
+    LockstepEngine engine(options.games, options.seed, options.ticks, options.preview, options.randomizer);
+    StepLog reference = runGames(options, actions, games);
+    StepLog lockstep = runEngine(options, actions, engine);
+    
+    size_t mismatches = 0;
+    unsigned long long endedGames = 0;
+    for (size_t k = 0; k < actions.size(); k++) {
+        if (reference.rewards[k] != lockstep.rewards[k] || reference.dones[k] != lockstep.dones[k]) mismatches++;
+        endedGames += reference.dones[k];
+    }
+    for (int i = 0; i < options.games; i++) {
+        const TetrisGame& game = games[i];
+        bool same = game.getScore() == engine.getScore(i) && game.getLines() == engine.getLines(i) &&
+                    game.getCurrentPiece().type == engine.getCurrentType(i);
+        for (int k = 0; k < options.preview; k++) {
+            same = same && game.getQueue().peek(k) == engine.getPreviewType(i, k);
+        }
+        if (!same) mismatches++;
+    }
+    
+    double total = (double)options.games * options.steps;
+    std::printf("%d games x %d steps, %d ticks per step, %llu games ended\n", options.games, options.steps,
+                options.ticks, endedGames);
+    std::printf("  TetrisGame  %8.2f M steps/s\n", total / reference.seconds / 1e6);
+    std::printf("  lockstep    %8.2f M steps/s\n", total / lockstep.seconds / 1e6);
+    std::printf("  speedup %.2fx, %zu mismatches\n", lockstep.seconds > 0 ? reference.seconds / lockstep.seconds : 0.0,
+                mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
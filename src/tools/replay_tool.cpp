@@ -0,0 +1,159 @@
+// Lists, filters and extracts games from a replay archive.
+// Usage:
+//   replay_tool <archive> list [--player NAME] [--min-score N] [--from YYYY-MM-DD] [--to YYYY-MM-DD]
+//   replay_tool <archive> extract <index> <out.replay>
+//   replay_tool <archive> seek <index> <tick>
+//   replay_tool <archive> verify <index>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include "../headers/ReplayArchive.h"
+
+// Days since 1970-01-01 for a proleptic Gregorian date
+static int64_t daysFromCivil(int y, int m, int d) {
+    y -= m <= 2;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    int64_t yoe = y - era * 400;
+    int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+static bool parseDateMs(const char* text, uint64_t& ms) {
+    int y, m, d;
+    if (std::sscanf(text, "%d-%d-%d", &y, &m, &d) != 3) return false;
+    ms = (uint64_t)daysFromCivil(y, m, d) * 86400000ULL;
+    return true;
+}
+
+static std::string formatDate(uint64_t ms) {
+    std::time_t seconds = (std::time_t)(ms / 1000);
+    char text[32];
+    std::strftime(text, sizeof(text), "%Y-%m-%d %H:%M", std::gmtime(&seconds));
+    return text;
+}
+
+static std::string playerName(const ReplayIndexEntry& e) {
+    return std::string(e.player, strnlen(e.player, sizeof(e.player)));
+}
+
+static void printBoard(const GameSnapshot& state) {
+    for (int y = 0; y < state.viewRows; y++) {
+        std::printf("|");
+        for (int x = 0; x < state.boardWidth; x++) {
+            int i = y - state.currentY;
+            int j = x - state.currentX;
+            bool active = !state.gameOver && i >= 0 && i < 4 && j >= 0 && j < 4 && state.current[i][j] != 0;
+            std::printf("%c", active ? '@' : (state.board[(size_t)y * state.boardWidth + x] != 0 ? '#' : '.'));
+        }
+        std::printf("|\n");
+    }
+    std::printf("score %d  lines %d%s\n", state.score, state.lines, state.gameOver ? "  (game over)" : "");
+}
+
+static int listGames(ReplayArchive& archive, int argc, char** argv) {
+    const char* player = nullptr;
+    int minScore = 0;
+    uint64_t from = 0, to = UINT64_MAX;
+    for (int i = 3; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--player") == 0) {
+            player = argv[i + 1];
+        } else if (std::strcmp(argv[i], "--min-score") == 0) {
+            minScore = std::atoi(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--from") == 0) {
+            if (!parseDateMs(argv[i + 1], from)) {
+                std::cerr << "Dates are YYYY-MM-DD" << std::endl;
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--to") == 0) {
+            if (!parseDateMs(argv[i + 1], to)) {
+                std::cerr << "Dates are YYYY-MM-DD" << std::endl;
+                return 1;
+            }
+            to += 86400000ULL; // Inclusive end day
+        } else {
+            std::cerr << "Unknown filter " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+    
+    // Filtering only reads the mapped index
+    std::printf("index,player,date,score,lines,seconds\n");
+    for (size_t i = 0; i < archive.size(); i++) {
+        const ReplayIndexEntry& e = archive.entry(i);
+        if (e.score < minScore || e.dateMs < from || e.dateMs >= to) continue;
+        if (player && playerName(e) != player) continue;
+        std::printf("%zu,%s,%s,%d,%d,%.1f\n", i, playerName(e).c_str(), formatDate(e.dateMs).c_str(),
+                    e.score, e.lines, (double)e.ticks / SIM_TICKS_PER_SECOND);
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: replay_tool <archive> list|extract|seek|verify ..." << std::endl;
+        return 1;
+    }
+    
+    ReplayArchive archive(argv[1]);
+    if (!archive.open()) {
+        std::cerr << "Cannot open archive " << argv[1] << std::endl;
+        return 1;
+    }
+    std::string command = argv[2];
+    if (command == "list") {
+        return listGames(archive, argc, argv);
+    }
+    
+    size_t index = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 0;
+    if (argc < 4 || index >= archive.size()) {
+        std::cerr << "Missing or invalid game index (archive holds " << archive.size() << " games)" << std::endl;
+        return 1;
+    }
+    
+    if (command == "extract" && argc > 4) {
+        std::string blob;
+        std::FILE* out = std::fopen(argv[4], "wb");
+        if (!archive.extract(index, blob) || !out) {
+            std::cerr << "Extract failed" << std::endl;
+            if (out) std::fclose(out);
+            return 1;
+        }
+        std::fwrite(blob.data(), 1, blob.size(), out);
+        std::fclose(out);
+        return 0;
+    }
+    
+    Replay replay;
+    if (!archive.load(index, replay)) {
+        std::cerr << "Replay " << index << " is corrupt" << std::endl;
+        return 1;
+    }
+    TetrisGame game(replay.seed);
+    GameSnapshot state;
+    
+    if (command == "seek" && argc > 4) {
+        uint32_t tick = (uint32_t)std::strtoul(argv[4], nullptr, 10);
+        if (tick > replay.ticks || !replay.seek(tick, game)) {
+            std::cerr << "Tick out of range (game has " << replay.ticks << " ticks)" << std::endl;
+            return 1;
+        }
+        game.snapshot(state);
+        printBoard(state);
+        return 0;
+    }
+    
+    if (command == "verify") {
+        // Full re-simulation from the first keyframe must reproduce the recorded result
+        bool ok = replay.seek(replay.ticks, game) && game.getScore() == replay.score && game.getLines() == replay.lines;
+        std::printf("%s: recorded %d/%d, simulated %d/%d\n", ok ? "OK" : "MISMATCH",
+                    replay.score, replay.lines, game.getScore(), game.getLines());
+        return ok ? 0 : 2;
+    }
+    
+    std::cerr << "Unknown command " << command << std::endl;
+    return 1;
+}
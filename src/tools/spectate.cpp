@@ -0,0 +1,171 @@
+// Watches a game streamed by `main --spectate PORT`, or load-tests the server.
+// Usage: spectate [--host 127.0.0.1] [--port 7777] [--connections N]
+// With --connections, opens N spectators that only count what they receive. Linux only.
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../headers/Spectator.h"
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static int connectTo(const char* host, int port, bool nonBlocking) {
+    int fd = socket(AF_INET, SOCK_STREAM | (nonBlocking ? SOCK_NONBLOCK : 0), 0);
+    if (fd < 0) return -1;
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    inet_pton(AF_INET, host, &addr.sin_addr);
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0 && errno != EINPROGRESS) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void printView(const SpectatorView& view) {
+    // The bottom of a tall board is where the action is
+    int first = std::max(0, std::min(view.top - 2, view.height - 40));
+    for (int y = first; y < view.height; y++) {
+        std::printf("|");
+        for (int x = 0; x < view.width; x++) {
+            int i = y - view.state.y;
+            int j = x - view.state.x;
+            bool active = i >= 0 && i < 4 && j >= 0 && j < 4 && (view.state.mask & (1 << (i * 4 + j)));
+            std::printf("%c", active ? '@' : (view.getCell(x, y) != 0 ? '#' : '.'));
+        }
+        std::printf("|\n");
+    }
+    std::printf("tick %llu  score %d  lines %d%s\n\n", (unsigned long long)view.tick, view.state.score,
+                view.state.lines, (view.state.flags & 1) ? "  (game over)" : "");
+}
+
+static int watch(const char* host, int port) {
+    int fd = connectTo(host, port, false);
+    if (fd < 0) {
+        std::cerr << "Cannot connect to " << host << ":" << port << std::endl;
+        return 1;
+    }
+    
+    SpectatorView view;
+    std::string pending;
+    char buffer[64 * 1024];
+    for (;;) {
+        ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+        if (received <= 0) break;
+        pending.append(buffer, received);
+        
+        // Apply every complete frame, then show the result once per read
+        size_t pos = 0;
+        bool applied = false;
+        while (pending.size() - pos >= 4) {
+            ByteReader reader(pending.data() + pos, 4);
+            uint32_t size = reader.u32();
+            if (pending.size() - pos - 4 < size) break;
+            if (!view.applyFrame((const uint8_t*)pending.data() + pos + 4, size)) {
+                std::cerr << "Malformed frame" << std::endl;
+                close(fd);
+                return 1;
+            }
+            pos += 4 + size;
+            applied = true;
+        }
+        pending.erase(0, pos);
+        if (applied) printView(view);
+    }
+    close(fd);
+    std::cout << "Server closed the stream" << std::endl;
+    return 0;
+}
+
+static int loadTest(const char* host, int port, int connections) {
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+    
+    int epollFd = epoll_create1(0);
+    int open = 0;
+    for (int i = 0; i < connections; i++) {
+        int fd = connectTo(host, port, true);
+        if (fd < 0) {
+            std::cerr << "Connection " << i << " failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+        epoll_event event = {};
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+        open++;
+    }
+    std::cout << open << " spectators connected" << std::endl;
+    
+    std::vector<epoll_event> events(4096);
+    char buffer[16 * 1024];
+    uint64_t bytes = 0;
+    auto lastReport = std::chrono::steady_clock::now();
+    while (open > 0) {
+        int count = epoll_wait(epollFd, events.data(), (int)events.size(), 1000);
+        for (int i = 0; i < count; i++) {
+            int fd = events[i].data.fd;
+            ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+            if (received > 0) {
+                bytes += received;
+            } else if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                close(fd);
+                open--;
+            }
+        }
+        
+        auto now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - lastReport).count();
+        if (elapsed >= 1.0) {
+            std::printf("%d open, %.1f KB/s total, %.1f B/s per spectator\n", open, bytes / elapsed / 1024,
+                        open > 0 ? bytes / elapsed / open : 0.0);
+            bytes = 0;
+            lastReport = now;
+        }
+    }
+    close(epollFd);
+    return 0;
+}
+
+#endif
+
+int main(int argc, char** argv) {
+    const char* host = "127.0.0.1";
+    int port = 7777;
+    int connections = 0;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--host") == 0 && i + 1 < argc) {
+            host = argv[++i];
+        } else if (std::strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--connections") == 0 && i + 1 < argc) {
+            connections = std::atoi(argv[++i]);
+        }
+    }
+
+#ifdef __linux__
+    return connections > 0 ? loadTest(host, port, connections) : watch(host, port);
+#else
+    (void)host;
+    (void)port;
+    (void)connections;
+    std::cerr << "spectate is only available on Linux" << std::endl;
+    return 1;
+#endif
+}
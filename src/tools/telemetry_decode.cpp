@@ -0,0 +1,95 @@
+// Converts a binary telemetry log into CSV (default) or JSON.
+// Usage: telemetry_decode <telemetry.bin> [--json]
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include "../headers/Telemetry.h"
+
+static bool readVarint(std::FILE* file, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int byte = std::fgetc(file);
+        if (byte == EOF) return false;
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: telemetry_decode <telemetry.bin> [--json]" << std::endl;
+        return 1;
+    }
+    bool json = argc > 2 && std::strcmp(argv[2], "--json") == 0;
+    
+    std::FILE* file = std::fopen(argv[1], "rb");
+    if (!file) {
+        std::cerr << "Cannot open " << argv[1] << std::endl;
+        return 1;
+    }
+    
+    uint8_t header[13];
+    if (std::fread(header, 1, sizeof(header), file) != sizeof(header) ||
+        std::memcmp(header, "TTEL", 4) != 0 || header[4] != TELEMETRY_VERSION) {
+        std::cerr << "Not a telemetry log (or unsupported version)" << std::endl;
+        std::fclose(file);
+        return 1;
+    }
+    uint64_t sessionStart = 0;
+    for (int i = 0; i < 8; i++) {
+        sessionStart |= (uint64_t)header[5 + i] << (8 * i);
+    }
+    
+    if (json) {
+        std::printf("{\"session_start_ms\":%llu,\"events\":[", (unsigned long long)sessionStart);
+    } else {
+        std::printf("time_us,event,arg0,arg1,arg2\n");
+    }
+    
+    uint64_t time = 0;
+    bool first = true;
+    int event;
+    while ((event = std::fgetc(file)) != EOF) {
+        uint64_t delta;
+        if (event >= (int)TelemetryEvent::Count || !readVarint(file, delta)) {
+            std::cerr << "Truncated or corrupt record" << std::endl;
+            break;
+        }
+        time += delta;
+        
+        const TelemetryEventInfo& info = TELEMETRY_EVENTS[event];
+        int32_t args[3] = {0, 0, 0};
+        bool ok = true;
+        for (int i = 0; i < info.argCount && ok; i++) {
+            uint64_t raw;
+            ok = readVarint(file, raw);
+            args[i] = (int32_t)((raw >> 1) ^ (~(raw & 1) + 1)); // Undo zigzag
+        }
+        if (!ok) {
+            std::cerr << "Truncated record" << std::endl;
+            break;
+        }
+        
+        if (json) {
+            std::printf("%s\n{\"time_us\":%llu,\"event\":\"%s\"", first ? "" : ",", (unsigned long long)time, info.name);
+            for (int i = 0; i < info.argCount; i++) {
+                std::printf(",\"%s\":%d", info.argNames[i], args[i]);
+            }
+            std::printf("}");
+        } else {
+            std::printf("%llu,%s", (unsigned long long)time, info.name);
+            for (int i = 0; i < 3; i++) {
+                if (i < info.argCount) std::printf(",%d", args[i]);
+                else std::printf(",");
+            }
+            std::printf("\n");
+        }
+        first = false;
+    }
+    if (json) std::printf("\n]}\n");
+    
+    std::fclose(file);
+    return 0;
+}